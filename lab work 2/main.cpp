@@ -2,6 +2,12 @@
 logic and display on the screen all formulas-consequences from these premises. */
 
 #include "mathlogic.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
 #include <windows.h>
 
 using namespace std;
@@ -249,36 +255,115 @@ void getTruthTable(Queue &input, Set &vars, std::vector<std::vector<int>> &a) {
     }
 }
 
-// Outputs CNF by the given set of disjuncts and all its combinations
-void writeExpr(std::vector<String> &d) {
-    static int D[100]; // formation of the combination
-    static int i = 0;
+// Outputs CNF by the given set of disjuncts and all its combinations.
+// Disjuncts before pos are already chosen and joined in line;
+// the combinations of the remaining ones are appended to out line by line
+void writeExpr(const std::vector<String> &d, size_t pos, String &line, String &out) {
     for (int x = 0; x <= 1; x++) {
-        D[i] = x;
-        if (i == d.size() - 1) {
-            int end = 1;
-            for (int v = 0; v < d.size(); v++) { // for all elements from the set of disjuncts
-                if (D[v]) {
-                    if (!end) { // if not reached the last disjunct, then output
-                        std::cout << "&" << d[v];
-                    } else { // if reached the end -- output the last disjunct and state that this is the end
-                        end = 0;
-                        std::cout << d[v];
-                    }
+        size_t len = line.size();
+        if (x) { // the disjunct is included in the combination
+            if (!line.empty())
+                line += "&";
+            line += d[pos];
+        }
+        if (pos == d.size() - 1) {
+            if (!line.empty()) // if there are disjuncts in the combination
+                out += line + "\n";
+        } else {
+            writeExpr(d, pos + 1, line, out);
+        }
+        line.resize(len);
+    }
+}
+
+// Outputs all combinations of the set of disjuncts using several threads.
+// The combination lattice is split into subtrees by the first disjuncts,
+// the threads take the subtrees in order, and the output of each subtree
+// is written in the same order as writeExpr does. A thread waits before
+// running too far ahead of the output, so only a few subtrees are held in memory.
+// In count-only mode nothing is formatted, only the number of combinations is found.
+// Returns the number of combinations
+unsigned long long writeExprParallel(const std::vector<String> &d, unsigned threads, bool countOnly) {
+    size_t n = d.size();
+    if (n == 0)
+        return 0;
+    if (countOnly) { // every non-empty subset of the disjuncts is a consequence
+        if (n >= 64)
+            throw String("Too many disjuncts to count the consequences!");
+        return (1ULL << n) - 1;
+    }
+    if (threads == 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    // Depth of the split: several subtrees per thread, so that the load can be balanced,
+    // and subtrees of at most 2^12 lines, so that the ones waiting for output stay small
+    size_t depth = 0;
+    while (depth < n - 1 && ((depth < 20 && (1u << depth) < 8 * threads) || n - depth > 12))
+        depth++;
+    size_t count = (size_t) 1 << depth;
+
+    size_t next = 0;    // the subtree to take next
+    size_t written = 0; // the subtrees whose output is written
+    size_t window = 2 * (size_t) threads; // subtrees taken but not yet written
+    std::vector<String> buffers(window); // output of the subtree t is kept at t % window
+    std::vector<char> ready(window, 0);
+    std::mutex readyMutex;
+    std::condition_variable readyCond, writtenCond;
+
+    auto worker = [&]() {
+        String line;
+        for (;;) {
+            size_t t;
+            {
+                std::unique_lock<std::mutex> lock(readyMutex);
+                writtenCond.wait(lock, [&] { return next == count || next < written + window; });
+                if (next == count)
+                    break;
+                t = next++;
+            }
+            // The first depth disjuncts are chosen by the bits of the subtree number
+            line.clear();
+            for (size_t v = 0; v < depth; v++) {
+                if (t >> (depth - 1 - v) & 1) {
+                    if (!line.empty())
+                        line += "&";
+                    line += d[v];
                 }
             }
-            if (!end) // if there are still disjuncts
-                std::cout << "\n";
-        } else {
-            i++;
-            writeExpr(d);
-            i--;
+            String out;
+            writeExpr(d, depth, line, out);
+            std::lock_guard<std::mutex> lock(readyMutex);
+            buffers[t % window].swap(out);
+            ready[t % window] = 1;
+            readyCond.notify_one();
         }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned k = 0; k < threads; k++)
+        pool.emplace_back(worker);
+
+    // Merge the output of the subtrees in their order as soon as they are ready
+    unsigned long long total = 0;
+    for (size_t t = 0; t < count; t++) {
+        String out;
+        {
+            std::unique_lock<std::mutex> lock(readyMutex);
+            readyCond.wait(lock, [&] { return ready[t % window] != 0; });
+            out.swap(buffers[t % window]);
+            ready[t % window] = 0;
+            written = t + 1;
+        }
+        writtenCond.notify_all();
+        total += std::count(out.begin(), out.end(), '\n');
+        std::cout << out;
     }
+    for (std::thread &th : pool)
+        th.join();
+    return total;
 }
 
 // Outputs all consequence formulas for all premise formulas found in s
-void OutputConsequences(String s) {
+// (or only their number in count-only mode)
+unsigned long long OutputConsequences(String s, unsigned threads, bool countOnly) {
     Queue input = stringToSequence(s);
     Queue output = infixToPostfix(input); // convert the sequence of tokens to RPN
     Set vars = getVariables(output); // set of variables
@@ -306,11 +391,31 @@ void OutputConsequences(String s) {
             result.push_back(d);
         }
     }
-    writeExpr(result);
+    return writeExprParallel(result, threads, countOnly);
 }
 
-int main() {
+// Command line: [-t number of threads] [-c (count the consequences only)]
+int main(int argc, char *argv[]) {
     SetConsoleOutputCP(CP_UTF8); // Connects to the Russian language
+    unsigned threads = 0; // as many threads as the hardware has
+    bool countOnly = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "-t") && i + 1 < argc) {
+            char *end;
+            long t = strtol(argv[++i], &end, 10);
+            if (*argv[i] == '\0' || *end != '\0' || t < 1 || t > 65535) {
+                printErrorMessage(String("Invalid number of threads ") + argv[i]
+                                  + ", usage: [-t number of threads] [-c]");
+                return 1;
+            }
+            threads = (unsigned) t;
+        } else if (!strcmp(argv[i], "-c")) {
+            countOnly = true;
+        } else {
+            printErrorMessage(String("Unknown option ") + argv[i]);
+            return 1;
+        }
+    }
     std::cout << "Enter the number of premise formulas:"; // read the number of premises
     int n;
     std::cin >> n;
@@ -324,7 +429,16 @@ int main() {
         std::cin >> s;
         res = res + "&" + "(" + s + ")";
     }
-    std::cout << "All consequence formulas:\n";  // output consequence formulas
-    OutputConsequences(res);
+    try {
+        if (countOnly) { // output only the number of consequence formulas
+            std::cout << "Number of consequence formulas: " << OutputConsequences(res, threads, true) << "\n";
+        } else {
+            std::cout << "All consequence formulas:\n";  // output consequence formulas
+            OutputConsequences(res, threads, false);
+        }
+    } catch (const String &err) {
+        printErrorMessage(err);
+        return 1;
+    }
     return 0;
 }
@@ -11,6 +11,14 @@
 #include <cstdlib>
 #include <vector>
 #include<locale>
+#include <cstdint>
+#include <fstream>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <tuple>
+#include <memory>
+#include <algorithm>
 
 // Declaration of types.
 // Token (lexeme):
@@ -27,6 +35,123 @@ typedef std::map<Token, Token> Map;
 typedef std::pair<Token, Token> VarVal;
 // String of characters:
 typedef std::string String;
+// Machine word of a fingerprint or a signature of a disjunct:
+typedef std::uint64_t Word;
+
+// Literal: 2 * j for the j-th variable, 2 * j + 1 for its negation
+inline int literal(unsigned var, bool negative) {
+    return 2 * var + (negative ? 1 : 0);
+}
+
+// Literal contrary to l
+inline int complement(int l) {
+    return l ^ 1;
+}
+
+// Number of literals in the first chunk of the arena, each next chunk
+// holds twice as many
+const size_t CHUNK_LITERALS = 256;
+
+// Origin of a disjunct that depends on the negated consequence
+// (the disjuncts following from the premises alone keep the number of a premise)
+const int ORIGIN_GOAL = -1;
+
+// Disjunct: its literals in increasing order, so the literals of a variable
+// are next to each other. It refers to literals kept elsewhere
+struct ClauseView {
+    const int* lits;
+    unsigned size;
+
+    ClauseView(const int* lits, unsigned size) : lits(lits), size(size) {}
+    ClauseView(const std::vector<int>& lits) : lits(lits.data()), size((unsigned) lits.size()) {}
+    const int* begin() const { return lits; }
+    const int* end() const { return lits + size; }
+};
+
+// Write or deletion of a disjunct, kept to be undone. A deleted disjunct
+// is kept with its literals, stamp, origin and step; a written one took
+// a new slot if it is fresh
+struct ClauseChange {
+    int n;
+    bool deletion;
+    bool fresh;
+    std::vector<int> lits;
+    unsigned age;
+    int origin;
+    int step;
+};
+
+// Set of disjuncts. The literals of each disjunct take a place of their own
+// length in an arena of chunks that grows one chunk at a time, doubling,
+// so the memory follows the number of literals written. A disjunct never
+// moves and its number stays valid while it is in use; the slots and the
+// places of deleted disjuncts are reused by new ones (a place by a disjunct
+// of the same length)
+struct ClauseSet {
+    unsigned countVars;
+    // Names of the variables
+    std::vector<String> names;
+    std::vector<std::vector<int> > chunks;
+    // Literals handed out: the place of the next disjunct is from here on
+    size_t used;
+    // Places of the deleted disjuncts by length
+    std::vector<std::vector<size_t> > freePlaces;
+    // Place of the literals of the disjunct in each slot and their number
+    std::vector<size_t> starts;
+    std::vector<unsigned> lengths;
+    // Number of slots handed out
+    int slots;
+    // Slots of deleted disjuncts
+    std::vector<int> freeSlots;
+    // Creation stamp of the disjunct in each slot, and the next stamp
+    std::vector<unsigned> ages;
+    unsigned clock;
+    // Occurrence index: the disjuncts containing each literal
+    // (may keep numbers of deleted disjuncts until it is compacted)
+    std::vector<std::vector<int> > occurs;
+    // Number of disjuncts deleted since the index was compacted
+    int deleted;
+    // Hash table of the disjuncts (open addressing, linear probing):
+    // fingerprint of a disjunct and its number, -1 in a free slot
+    std::vector<std::pair<Word, int> > table;
+    // Signatures of the disjuncts for a quick subsumption check
+    std::vector<Word> sigs;
+    // Whether the slot holds a disjunct in use
+    std::vector<char> alive;
+    // Origin of each disjunct: the number of a premise or ORIGIN_GOAL
+    std::vector<int> origins;
+    // Step of the derivation of each disjunct, -1 if it is not recorded
+    std::vector<int> steps;
+    // While keepChanges is set, the writes and deletions are kept in changes
+    // for UndoChanges
+    bool keepChanges;
+    std::vector<ClauseChange> changes;
+
+    explicit ClauseSet(unsigned countVars)
+        : countVars(countVars), names(countVars), used(0), slots(0), clock(0),
+          occurs(2 * countVars), deleted(0), table(16, std::pair<Word, int>(0, -1)),
+          keepChanges(false) {}
+
+    // Number of slots (the numbers of disjuncts are below it)
+    int size() const { return slots; }
+    // Number of disjuncts in use
+    int count() const { return slots - (int) freeSlots.size(); }
+    // Chunk c holds the literals from firstLiteral(c) on
+    static int chunkOf(size_t k) { return 63 - __builtin_clzll(k / CHUNK_LITERALS + 1); }
+    static size_t firstLiteral(int c) { return CHUNK_LITERALS * (((size_t) 1 << c) - 1); }
+    // The n-th disjunct
+    ClauseView clause(int n) const {
+        if (lengths[n] == 0)
+            return ClauseView(NULL, 0);
+        int c = chunkOf(starts[n]);
+        return ClauseView(&chunks[c][starts[n] - firstLiteral(c)], lengths[n]);
+    }
+};
+
+// Does the disjunct contain the literal l?
+inline bool HasLiteral(ClauseView a, int l) {
+    return std::binary_search(a.begin(), a.end(), l);
+}
 
 // Is the token a number?
 inline bool isNumber(Token t) {
@@ -205,30 +330,611 @@ void evalOpUsingStack(Token op, Stack &s);
 // Calculate the value of an expression written in postfix notation
 Token evaluate(Queue expr);
 
-// Construct the matrix of CNF formulas 
-int SKNF(Queue expr, int** matr, Set vars, unsigned countVars);
+// Order in which the resolution method selects the given disjuncts
+enum Selection {
+    SELECT_WEIGHT, // the shortest disjunct first, the oldest among equal ones
+    SELECT_AGE     // the oldest disjunct first
+};
+
+// Pairs of disjuncts the resolution method resolves
+enum Restriction {
+    RESOLVE_FULL,    // every pair on any contrary literals
+    RESOLVE_ORDERED, // only on the greatest literal of both disjuncts
+    RESOLVE_LINEAR,  // a chain from a disjunct of the negated consequence
+    RESOLVE_HYPER    // positive hyperresolution
+};
+
+// Conversion of the formulas to the set of disjuncts
+enum Conversion {
+    CNF_TABLE,  // perfect CNF by the truth table
+    CNF_TSEITIN // Tseitin transformation with auxiliary variables
+};
+
+// Algorithm that decides whether the set of disjuncts is contradictory
+enum Engine {
+    ENGINE_RESOLUTION, // saturation by the resolution method, with an explanation
+    ENGINE_CDCL        // search for a satisfying assignment with clause learning
+};
+
+// State of the search reported to the progress callback
+struct Progress {
+    size_t clauses;           // disjuncts in use
+    size_t memory;            // bytes
+    unsigned long long steps; // resolutions (conflicts for CDCL)
+    double seconds;
+    double rate;              // steps per second
+};
+
+// Resources the search may use, zero means no limit
+struct Budget {
+    size_t maxClauses;
+    size_t maxMemory;            // bytes
+    unsigned long long maxSteps; // resolutions (conflicts for CDCL)
+    double timeLimit;            // seconds
+    // Set by another thread to stop the search
+    const std::atomic<bool>* cancel;
+    // Called every progressInterval seconds (never if it is empty)
+    std::function<void(const Progress&)> progress;
+    double progressInterval;
+
+    Budget() : maxClauses(0), maxMemory(0), maxSteps(0), timeLimit(100), cancel(NULL),
+               progressInterval(1) {}
+};
+
+// Settings of the prover
+struct ProverOptions {
+    Conversion cnf;
+    Engine engine;
+    Selection selection;
+    Restriction restriction;
+    // Variables of ordered resolution from the greatest, separated by commas;
+    // the others are smaller, the later one is greater
+    String order;
+    // DIMACS CNF file to read the disjuncts from instead of the formulas (none if empty)
+    String dimacsFile;
+    // File to write the simplified disjuncts to in DIMACS CNF (none if empty)
+    String exportFile;
+    // File for the proof in DRAT or LRAT format (none if empty)
+    String proofFile;
+    bool lrat;
+    // Simplify the disjuncts before the proof
+    bool preprocess;
+    // Eliminate variables by resolution before the proof
+    bool eliminate;
+    // Select only the negated consequence and its descendants
+    // (complete when the premises are consistent)
+    bool setOfSupport;
+    // Threads of the resolution method (deterministic batches if more than one)
+    unsigned threads;
+    // Race several strategies on separate threads
+    bool portfolio;
+    // Check several goals against the premises in one session
+    bool session;
+    // Report the premises the proof uses; minimize them by further proofs
+    // (the CDCL solver keeps no derivation, so it always minimizes)
+    bool core;
+    bool minimizeCore;
+    Budget budget;
+
+    ProverOptions() : cnf(CNF_TABLE), engine(ENGINE_RESOLUTION), selection(SELECT_WEIGHT),
+                      restriction(RESOLVE_FULL), lrat(false), preprocess(false), eliminate(false),
+                      setOfSupport(false), threads(1), portfolio(false), session(false),
+                      core(false), minimizeCore(false) {}
+};
+
+// Why the search was stopped before it finished
+enum Stop {
+    STOP_NONE,
+    STOP_CLAUSES,
+    STOP_MEMORY,
+    STOP_STEPS,
+    STOP_TIME,
+    STOP_CANCELLED
+};
+
+// The clock and the memory are looked at once in so many checks
+const unsigned GUARD_PERIOD = 16;
+
+// Keeps a search within its budget. The search calls stop() in its inner
+// loop and gives up as soon as it returns true
+class SearchGuard {
+
+    public:
+        explicit SearchGuard(const Budget& budget);
+        // Should the search stop? The limits on disjuncts and steps and the
+        // cancellation are checked at every call, the time, the memory
+        // (memory() is called) and the progress report every GUARD_PERIOD calls
+        bool stop(size_t clauses, unsigned long long steps, const std::function<size_t()>& memory);
+        // Seconds since the start of the search
+        double seconds() const;
+        Stop stopped;
+
+    private:
+        const Budget& budget;
+        std::chrono::steady_clock::time_point start;
+        double nextReport;
+        unsigned calls;
+};
+
+// Description of the reason the search was stopped for
+const char* StopReason(Stop stop);
+
+// x-th element of the Luby sequence with base y: 1, 1, y, 1, 1, y, y^2, ...
+double luby(double y, int x);
+
+// Conflict-driven clause learning (CDCL) SAT solver over a set of disjuncts:
+// two watched literals per disjunct, EVSIDS choice of the decision variable
+// with saved phases, learning of first-UIP disjuncts, Luby restarts
+// and deletion of the least useful learnt disjuncts
+class Solver {
+
+    public:
+        explicit Solver(const ClauseSet& matr);
+        // Is the set of disjuncts satisfiable with the assumed literals true?
+        // Meaningless if the guard stopped the search. It may be called again
+        // after adding disjuncts, the learnt ones are kept
+        bool solve(SearchGuard& guard, const std::vector<int>& assumptions = std::vector<int>());
+        // Add variables after the others
+        void addVariables(unsigned count);
+        // Drop the variables from the first one on with the disjuncts,
+        // learnt ones too, that contain them
+        void removeVariables(unsigned first);
+        // Add a disjunct between the searches
+        void addClause(std::vector<int> lits);
+        // Bytes taken by the disjuncts of the solver
+        size_t memory() const;
+        // Value of the variable in the found assignment (0 or 1)
+        int value(unsigned var) const;
+        unsigned long long conflicts;
+        unsigned long long decisions;
+        unsigned long long propagations;
+
+    private:
+        struct SolverClause {
+            std::vector<int> lits; // the first two literals are watched
+            bool learnt;
+            bool deleted;
+            unsigned lbd;          // number of decision levels among the literals
+            double activity;
+        };
+        unsigned countVars;
+        bool contradiction;                     // the empty disjunct was met
+        std::vector<SolverClause> clauses;
+        std::vector<std::vector<int> > watches; // by literal: the disjuncts watching it
+        std::vector<signed char> values;        // by variable: -1 unassigned, 0 or 1
+        std::vector<int> levels;                // by variable: decision level of the value
+        std::vector<int> reasons;               // by variable: the disjunct implying it, -1 for decisions
+        std::vector<char> phases;               // by variable: the last value
+        std::vector<char> seen;
+        std::vector<int> trail;                 // assigned literals in order
+        std::vector<int> trailLim;              // trail size at each decision
+        size_t qhead;                           // first literal of the trail not propagated
+        std::vector<double> activity;           // by variable
+        double varInc;
+        double clauseInc;
+        std::vector<int> heap;                  // variables ordered by activity (max-heap)
+        std::vector<int> heapPos;               // by variable: position in the heap, -1 if absent
+        size_t learnts;
+        size_t maxLearnts;
+        int litValue(int l) const;
+        int decisionLevel() const;
+        void attach(int c);
+        void enqueue(int l, int reason);
+        int propagate();
+        void analyze(int confl, std::vector<int>& learnt, int& backLevel, unsigned& lbd);
+        void backtrack(int level);
+        void bumpVar(int v);
+        void bumpClause(int c);
+        void heapUp(int i);
+        void heapDown(int i);
+        void heapInsert(int v);
+        void heapRemove(int v);
+        int heapPop();
+        int pickBranchLit();
+        void reduceLearnts();
+        int addLearnt(const std::vector<int>& lits, unsigned lbd);
+};
+
+// Read the settings of the prover from the command line
+ProverOptions parseOptions(int argc, char* argv[]);
+
+// Construct the set of CNF disjuncts
+int SKNF(Queue expr, ClauseSet& matr, Set vars, unsigned countVars);
+
+// Node of the tree of a formula: a variable or a constant (no children)
+// or an operation with its operands (numbers of nodes, -1 if absent)
+struct FormulaNode {
+    Token op;
+    int left;
+    int right;
+};
+
+// Build the tree of a formula written in postfix notation,
+// the root is the last node
+std::vector<FormulaNode> FormulaTree(Queue expr);
+
+// Number of auxiliary variables the Tseitin transformation
+// introduces for a formula in postfix notation
+unsigned TseitinVars(Queue expr);
+
+// Construct an equisatisfiable set of disjuncts by the Tseitin transformation
+// (only the implications needed by the polarity of each subformula are written,
+// as Plaisted and Greenbaum do). The variables of the formula are numbered
+// by their order in vars, auxiliary ones are taken from nextVar on.
+// Return the number of disjuncts written
+int Tseitin(Queue expr, ClauseSet& matr, Set vars, unsigned& nextVar);
+
+// Write the disjunct of the literals lits unless it is a tautology or is already in the set,
+// return its number (-1 if it was not written)
+int WriteClause(ClauseSet& matr, const std::vector<int>& lits);
 
 // Check if the resolvent is empty 
-bool EmptySequence(int* a, unsigned countVars) ;
+bool EmptySequence(ClauseView a);
 
+// Check for equality of disjuncts 
+bool EqvivArr(ClauseView a, ClauseView b);
 
-// Check for equality of arrays 
-bool EqvivArr(int* a, int* b, unsigned countVars);
+// Number of literals in the disjunct
+unsigned ClauseWeight(ClauseView a);
 
-// Search for an array in the matrix 
-bool SearchArr(int** matr, int n, unsigned countVars, int* a);
+// Does the disjunct contain a variable together with its negation?
+bool Tautology(ClauseView a);
 
-// Write to the matrix of disjunctions 
-void WriteArr(int** matr, int* n, unsigned countVars, int* a);
+// Signature of the disjunct: if a is a subset of b,
+// then the signature of a is a subset of the signature of b
+Word ClauseSignature(ClauseView a);
 
-// Output the disjunction 
-void PrintfArr(int** matr, int n, unsigned countVars, Set vars);
+// Is the disjunct a a subset of the disjunct b?
+bool Subsumes(ClauseView a, ClauseView b);
+
+// Search for a disjunct in use that subsumes a, return its number or -1
+int ForwardSubsumed(const ClauseSet& matr, ClauseView a);
+
+// Delete the disjuncts in use subsumed by the n-th disjunct,
+// put their numbers into removed
+void BackwardSubsume(ClauseSet& matr, int n, std::vector<int>& removed);
+
+// Put the literals of the disjunct into lits
+void ClauseLiterals(ClauseView a, std::vector<int>& lits);
+
+// Build the resolvent r of disjuncts a and b (r is neither of them),
+// return the number of contrary pairs of literals in them
+unsigned Resolve(ClauseView a, ClauseView b, std::vector<int>& r);
 
-// Resolution method 
-bool MethodResolution(int** matr, int n, unsigned countVars, Set vars);
+// 64-bit fingerprint of a disjunct
+Word ClauseHash(ClauseView a);
+
+// Put the n-th disjunct with fingerprint h into the hash table
+void InsertHash(std::vector<std::pair<Word, int> >& table, Word h, int n);
+
+// Search for a disjunct in the set 
+bool SearchArr(const ClauseSet& matr, ClauseView a);
+
+// Remove the n-th disjunct from the hash table
+void EraseHash(std::vector<std::pair<Word, int> >& table, Word h, int n);
+
+// Write to the set of disjuncts, to its occurrence index and hash table,
+// return the number of the new disjunct
+int WriteArr(ClauseSet& matr, ClauseView a);
+
+// Delete the n-th disjunct, its slot will be reused
+void DeleteArr(ClauseSet& matr, int n);
+
+// Drop the numbers of deleted disjuncts from the occurrence index
+void CompactOccurs(ClauseSet& matr);
+
+// Add count variables after the others
+void AddVariables(ClauseSet& matr, unsigned count);
+
+// Drop the variables from the first one on; no disjunct in use may contain them
+void RemoveVariables(ClauseSet& matr, unsigned first);
+
+// Undo the changes kept since keepChanges was set, the latest first,
+// and stop keeping them. A deleted disjunct gets its slot back
+void UndoChanges(ClauseSet& matr);
+
+// Number of bytes taken by the set of disjuncts
+size_t MemoryUsage(const ClauseSet& matr);
+
+// Output the disjunction of the literals
+void PrintfLits(std::vector<int> lits, const std::vector<String>& names);
+
+// Output the disjunction 
+void PrintfArr(const ClauseSet& matr, int n);
+
+// Step of a derivation: a disjunct and the steps it was resolved from
+// (-1 for the disjuncts of the premises and the consequence)
+struct ProofStep {
+    std::vector<int> lits;
+    int left;
+    int right;
+    int origin; // of an input disjunct: the number of its premise or ORIGIN_GOAL
+};
+
+// Derivation of the disjuncts, optionally streamed to a proof file
+// in DRAT or LRAT format (the input disjuncts are numbered from 1 in LRAT)
+struct Derivation {
+    std::vector<ProofStep> steps;
+    int empty; // step of the empty disjunct, -1 if it was not derived
+    std::ofstream file;
+    bool lrat;
+
+    Derivation() : empty(-1), lrat(false) {}
+};
+
+// Record a step of the derivation and write it to the proof file, return its number
+int AddStep(Derivation& proof, const std::vector<int>& lits, int left, int right);
+
+// Write the deletion of the n-th disjunct to the proof file
+void ForgetStep(Derivation& proof, const ClauseSet& matr, int n);
+
+// Record the disjuncts in use as the input steps of the derivation
+void RecordInputs(ClauseSet& matr, Derivation& proof);
+
+// File mapped into memory for reading
+class MappedFile {
+
+    public:
+        explicit MappedFile(const String& path);
+        ~MappedFile();
+        const char* data() const { return bytes; }
+        size_t size() const { return length; }
+
+    private:
+        MappedFile(const MappedFile&);
+        MappedFile& operator=(const MappedFile&);
+        const char* bytes;
+        size_t length;
+#ifdef _WIN32
+        void* file;
+        void* mapping;
+#endif
+};
+
+// Read the disjuncts of a DIMACS CNF file, the variables are named by their
+// numbers. Every disjunct of the file gets an input step of the derivation
+// in the order of the file, so the proof refers to them by their numbers;
+// tautologies and repeated disjuncts are not put into the set. A header
+// with a wrong number of disjuncts is only warned about
+ClauseSet ReadDimacs(const String& path, Derivation& proof);
+
+// Write the disjuncts in use in DIMACS CNF, in the order of their slots;
+// the names of the variables are given in comments. A contradictory set
+// gets the empty disjunct last
+void WriteDimacs(const ClauseSet& matr, std::ostream& out, bool contradictory = false);
+
+// Unprocessed disjuncts of the resolution method ordered by (weight, age);
+// the number is the last field. An entry is outdated if its disjunct
+// was deleted and the slot reused
+typedef std::tuple<unsigned, unsigned, int> Priority;
+typedef std::priority_queue<Priority, std::vector<Priority>, std::greater<Priority> > Agenda;
+
+// Put the n-th disjunct into the unprocessed ones
+void PushUnprocessed(Agenda& unprocessed, const ClauseSet& matr, const ProverOptions& options, int n);
+
+// Given disjuncts taken at once by the parallel resolution method
+const size_t PARALLEL_BATCH = 32;
+
+// Resolvent found by a thread of the parallel resolution method
+struct Candidate {
+    std::vector<int> a;
+    int left, right;            // numbers of the parents
+    unsigned leftAge, rightAge; // their ages, to see that they are still in use
+};
+
+// The given-clause loop of the resolution method: the unprocessed disjuncts are
+// resolved with the processed ones until the empty disjunct is derived (true)
+// or they run out. It may be called again to go on after the guard stopped it
+bool Saturate(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+              SearchGuard& guard, Agenda& unprocessed, std::vector<char>& isProcessed);
+
+// The given-clause loop of the resolution method on options.threads threads
+bool SaturateParallel(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+                      SearchGuard& guard, Agenda& unprocessed, std::vector<char>& isProcessed);
+
+// Rank of each variable in the order of ordered resolution
+std::vector<unsigned> VariableRanks(const ClauseSet& matr, const String& order);
+
+// The greatest literal of the disjunct by the ranks of the variables, -1 if it is empty
+int MaxLiteral(ClauseView a, const std::vector<unsigned>& ranks);
+
+// Does the disjunct have no negative literals?
+bool Positive(ClauseView a);
+
+// Positive hyperresolution: a disjunct with negative literals (nucleus)
+// is resolved on all of them with positive disjuncts (electrons) at once.
+// Return true if the empty disjunct was derived
+bool HyperResolution(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+                     SearchGuard& guard);
+
+// Center of linear resolution: a disjunct with the center it was resolved from
+struct LinearCenter {
+    std::vector<int> a;
+    int step;   // in the derivation
+    int parent; // number of the previous center, -1 for a disjunct of the consequence
+};
+
+// Linear resolution from the negated consequence: every center is resolved
+// with a disjunct of the input or one of its ancestors, each disjunct is
+// a center once. Return true if the empty disjunct was derived; when the centers run out,
+// nothing follows (the premises may be contradictory by themselves)
+bool LinearResolution(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+                      SearchGuard& guard);
+
+// Resolution method. The derivation of every stored resolvent is recorded in proof.
+// False is also returned when the guard stops the search
+bool MethodResolution(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+                      SearchGuard& guard);
+
+// Session checking many goals against the same premises. The premises are
+// converted to disjuncts once, then the resolution method saturates them or
+// the CDCL solver takes them; a goal adds only the disjuncts of its negation,
+// which are retracted after the check. The resolution method goes back to the
+// saturated set of disjuncts; the solver keeps its learnt disjuncts, and the
+// disjuncts of a goal carry the negation of a selector variable, assumed true
+// during the check and made false after it. The letters are numbered in the
+// order they are met, each goal may bring new ones
+class ProofSession {
+
+    public:
+        ProofSession(const std::vector<String>& premises, const ProverOptions& options);
+        // Saturate the premises or solve them; the goals are decided all the same
+        // if the guard stops it, only more slowly
+        void prepare(SearchGuard& guard);
+        // Does the goal follow from the premises? 1 if it does, 0 if it does not,
+        // -1 if the guard stopped the search
+        int check(const String& goal, SearchGuard& guard);
+        // Are the premises contradictory (then every goal follows)?
+        bool contradictory() const { return inconsistent; }
+        // Letters of the premises and the last goal with their values in the
+        // counterexample found by the solver (empty for the resolution method)
+        std::vector<std::pair<Token, int> > counterexample() const;
+        // Disjuncts kept between the goals
+        int count() const;
+        // Bytes taken by them
+        size_t memory() const;
+
+    private:
+        ProverOptions options;
+        ClauseSet matr;                 // the premises, saturated by the resolution method
+        Derivation proof;
+        Agenda unprocessed;             // of the resolution method, if the guard stopped it
+        std::vector<char> isProcessed;
+        std::unique_ptr<Solver> solver;
+        std::map<Token, unsigned> index; // variable of each letter
+        Set premiseLetters, goalLetters;
+        std::vector<int> values;         // counterexample to the last goal
+        bool inconsistent;
+        unsigned addVariables(unsigned count);
+        // Return the first auxiliary variable of the formula
+        unsigned convert(const String& formula, Set& letters, std::vector<std::vector<int> >& clauses);
+};
+
+// Disjuncts removed by the simplification, each with the literal that
+// satisfies it. A model of the remaining disjuncts is extended to them
+// by going through the list backwards
+typedef std::vector<std::pair<int, std::vector<int> > > Reconstruction;
+
+// Extend the assignment (value of each variable) to the removed disjuncts
+void ExtendModel(const Reconstruction& rec, std::vector<int>& values);
+
+// What the simplification removed
+struct PreprocessStats {
+    int clauses;   // disjuncts removed
+    int variables; // variables that no longer occur
+    int units;     // literals fixed by unit propagation
+    int pure;      // pure literals
+    int failed;    // failed literals found by probing
+};
+
+// Write the literals to the proof file in DIMACS numbering
+void WriteProofLits(std::ofstream& file, const std::vector<int>& lits);
+
+// Remove the n-th disjunct, remembering that the literal l satisfies it
+void RemoveClause(ClauseSet& matr, Derivation& proof, Reconstruction& rec, int n, int l);
+
+// Numbers of the disjuncts in use containing the literal l
+std::vector<int> ClausesWith(const ClauseSet& matr, int l);
+
+// Unit propagation of the literal l: assign holds the values of the variables
+// (-1 unassigned), trail gets the implied literals with the disjuncts implying them.
+// Return the number of a falsified disjunct or -1
+int ProbeLiteral(const ClauseSet& matr, int l, std::vector<int>& assign,
+                 std::vector<std::pair<int, int> >& trail);
+
+// Simplify the set of disjuncts before the proof: unit propagation,
+// pure literal elimination, removal of tautologies and failed literal probing.
+// Return true if the empty disjunct was derived; false also if the guard stopped the pass
+bool Preprocess(ClauseSet& matr, Derivation& proof, Reconstruction& rec, PreprocessStats& stats,
+                SearchGuard& guard);
+
+// Variables with more occurrences of each sign are not eliminated
+const size_t ELIMINATE_OCC_LIMIT = 16;
+
+// Bounded variable elimination (Davis-Putnam, as in SatELite): a variable is
+// replaced by all non-tautological resolvents on it when there are no more
+// of them than disjuncts containing it; the cheapest variables go first.
+// eliminated gets the number of eliminated variables.
+// Return true if the empty disjunct was derived; false also if the guard stopped the pass
+bool EliminateVariables(ClauseSet& matr, Derivation& proof, Reconstruction& rec, int& eliminated,
+                        SearchGuard& guard);
+
+// The truth table is tried only for so few variables
+const unsigned TRUTH_TABLE_VARS = 20;
+
+// Look through the assignments of the variables for one satisfying
+// the disjuncts in use, put it into values.
+// Return 1 if it was found, 0 if there is none, -1 if the guard stopped the search
+int TruthTable(const ClauseSet& matr, std::vector<int>& values, SearchGuard& guard);
+
+// Strategy raced by the portfolio
+enum Strategy {
+    STRATEGY_WEIGHT,     // resolution, the lightest disjuncts first
+    STRATEGY_AGE,        // resolution, the oldest disjuncts first
+    STRATEGY_SOS,        // resolution with the set of support (proofs only)
+    STRATEGY_ORDERED,
+    STRATEGY_HYPER,
+    STRATEGY_LINEAR,     // proofs only
+    STRATEGY_CDCL,
+    STRATEGY_TRUTH_TABLE // for TRUTH_TABLE_VARS variables at most
+};
+
+// A strategy of the portfolio, working on its own copy of the disjuncts
+struct PortfolioRun {
+    Strategy strategy;
+    const char* name;
+    ClauseSet matr;
+    std::unique_ptr<Derivation> proof;
+    std::vector<int> values; // the satisfying assignment found
+    int verdict;             // 1 the theorem is proven, 0 disproven, -1 no verdict
+    Stop stopped;
+    double seconds;
+
+    PortfolioRun(Strategy strategy, const char* name, const ClauseSet& matr)
+        : strategy(strategy), name(name), matr(matr), proof(new Derivation()), verdict(-1),
+          stopped(STOP_NONE), seconds(0) {}
+};
+
+// Start the strategies suitable for the disjuncts on separate threads,
+// stop the others as soon as one of them reaches a verdict. The derivation
+// of each strategy goes on from a copy of proof, the derivation of the disjuncts.
+// Return the number of the winner in runs, -1 if there is none
+int Portfolio(const ClauseSet& matr, const Derivation& proof, const ProverOptions& options,
+              std::vector<PortfolioRun>& runs);
+
+// Output the counterexample: the values of the first countVars variables,
+// extended to the disjuncts removed by the simplification
+void PrintfCounterexample(const ClauseSet& matr, const Reconstruction& rec,
+                          std::vector<int> values, unsigned countVars);
+
+// Steps the empty disjunct depends on (none if it was not derived)
+std::vector<char> NeededSteps(const Derivation& proof);
+
+// Unsatisfiable core: the input disjuncts the empty disjunct is derived from
+struct Core {
+    std::vector<int> steps;    // their steps in the derivation
+    std::vector<int> premises; // the premises they come from, in order
+    bool goal;                 // whether the negated consequence takes part
+};
+
+Core ProofCore(const Derivation& proof);
+
+// Deletion-based minimization of the premises of a core: a premise is dropped
+// if the others with the negated consequence are still contradictory, and the
+// proof of that drops the premises it does not use as well. matr is the input
+// set of disjuncts. The checks share the time of the guard; when it stops,
+// the premises kept so far are returned. tries counts the checks
+std::vector<int> MinimizeCore(const ClauseSet& matr, const ProverOptions& options,
+                              std::vector<int> premises, SearchGuard& guard, int& tries);
+
+// Output the core
+void PrintfCore(const Core& core, size_t inputs, bool dimacs);
+
+// Output the unifications the empty disjunct was derived by
+void PrintfProof(const Derivation& proof, const ClauseSet& matr);
 
 // Output the set of disjuncts
-void PrintfSetDis(int** matr, int n, int countVars, Set vars);
+void PrintfSetDis(const ClauseSet& matr);
 
 // Display the calculation result on the screen
 void printResult(Token r);
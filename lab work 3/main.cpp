@@ -3,6 +3,24 @@
 // but also an explanation of the proof, namely the original set of disjuncts and the gluings performed.
 
 #include "logicmath.h"
+#include <algorithm>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // Convert a sequence of tokens,
 // representing an expression in infix notation,
@@ -228,11 +246,12 @@ void printResult(Token r) {
     std::cout << "Value of the expression: " << r << std::endl;
 }
 
-// Construct the matrix of CNF formulas 
-int SKNF(Queue expr, int** matr, Set vars, unsigned countVars) {
+// Construct the set of CNF disjuncts
+int SKNF(Queue expr, ClauseSet& matr, Set vars, unsigned countVars) {
     unsigned mask;
     unsigned lim = 1 << countVars; // Calculate limit based on the number of variables
     unsigned c = 0;
+    std::vector<int> a;
 
     // Iterate through all possible combinations of truth values
     for (size_t i = 0; i < lim; i++) {
@@ -252,191 +271,3153 @@ int SKNF(Queue expr, int** matr, Set vars, unsigned countVars) {
         Queue sExpr = substValues(expr, varVals); // Substitute values in the expression
         Token res = evaluate(sExpr); // Evaluate the substituted expression
 
-        // If the result is false, update the matrix
+        // If the result is false, add the disjunct of this row
         if (res == '0') {
+            a.clear();
             mask = lim;
             for (size_t j = 0; j < countVars; j++) { // Declare j here
                 mask >>= 1;
                 bool t = i & mask;
-                if (t == true) {
-                    (*matr)[j] = -1; // Set to -1 if the variable is true
-                } else {
-                    (*matr)[j] = 0; // Set to 0 if the variable is false
+                // Negative literal if the variable is true, positive if it is false
+                a.push_back(literal((unsigned) j, t));
+            }
+            if (!SearchArr(matr, a)) { // The same disjunct may come from another formula
+                WriteArr(matr, a);
+                c++;
+            }
+        }
+    }
+    return c; // Return the number of clauses generated
+
+}
+
+
+// Build the tree of a formula written in postfix notation,
+// the root is the last node
+std::vector<FormulaNode> FormulaTree(Queue expr) {
+    std::vector<FormulaNode> tree;
+    std::stack<int> s; // nodes not yet taken as operands
+    while (!expr.empty()) {
+        Token t = expr.front();
+        expr.pop();
+        FormulaNode node = { t, -1, -1 };
+        if (isOperation(t)) {
+            if (s.empty())
+                throw String("Invalid expression!");
+            node.right = s.top();
+            s.pop();
+            if (isBinOp(t)) {
+                if (s.empty())
+                    throw String("Invalid expression!");
+                node.left = s.top();
+                s.pop();
+            }
+        }
+        s.push((int) tree.size());
+        tree.push_back(node);
+    }
+    if (s.size() != 1)
+        throw String("Invalid expression!");
+    return tree;
+}
+
+// Number of auxiliary variables the Tseitin transformation
+// introduces for a formula in postfix notation:
+// one per binary operation and per constant
+unsigned TseitinVars(Queue expr) {
+    unsigned c = 0;
+    while (!expr.empty()) {
+        if (isBinOp(expr.front()) || isNumber(expr.front()))
+            c++;
+        expr.pop();
+    }
+    return c;
+}
+
+// Write the disjunct of the literals lits unless it is a tautology or is already in the set
+int WriteClause(ClauseSet& matr, const std::vector<int>& lits) {
+    std::vector<int> a(lits);
+    std::sort(a.begin(), a.end());
+    a.erase(std::unique(a.begin(), a.end()), a.end());
+    if (Tautology(a) || SearchArr(matr, a))
+        return -1;
+    return WriteArr(matr, a);
+}
+
+// Polarities of a subformula: it must imply its variable (POSITIVE)
+// or be implied by it (NEGATIVE)
+const int POSITIVE = 1;
+const int NEGATIVE = 2;
+
+// Literal of the n-th node of the tree standing for its subformula;
+// writes the disjuncts defining the auxiliary variables of the subtree
+int TseitinNode(const std::vector<FormulaNode>& tree, int n, int polarity, ClauseSet& matr,
+                const std::map<Token, unsigned>& index, unsigned& nextVar) {
+    const FormulaNode& node = tree[n];
+    if (isVariable(node.op))
+        return literal(index.at(node.op), false);
+    if (isUnarOp(node.op)) { // negation needs no variable, only the opposite polarity
+        int flipped = (polarity & POSITIVE ? NEGATIVE : 0) | (polarity & NEGATIVE ? POSITIVE : 0);
+        return complement(TseitinNode(tree, node.right, flipped, matr, index, nextVar));
+    }
+    int x = literal(nextVar++, false);
+    int nx = complement(x);
+    if (isNumber(node.op)) { // a constant is a variable with a fixed value
+        WriteClause(matr, std::vector<int>(1, logicVal(node.op) ? x : nx));
+        return x;
+    }
+    // Polarities of the operands
+    int lp = polarity, rp = polarity;
+    if (node.op == '>')
+        lp = (polarity & POSITIVE ? NEGATIVE : 0) | (polarity & NEGATIVE ? POSITIVE : 0);
+    else if (node.op == '~')
+        lp = rp = POSITIVE | NEGATIVE;
+    int a = TseitinNode(tree, node.left, lp, matr, index, nextVar);
+    int b = TseitinNode(tree, node.right, rp, matr, index, nextVar);
+    int na = complement(a), nb = complement(b);
+    bool pos = polarity & POSITIVE, neg = polarity & NEGATIVE;
+    switch (node.op) {
+        case '&': // x ~ a & b
+            if (pos) {
+                WriteClause(matr, { nx, a });
+                WriteClause(matr, { nx, b });
+            }
+            if (neg)
+                WriteClause(matr, { x, na, nb });
+            break;
+        case '|': // x ~ a | b
+            if (pos)
+                WriteClause(matr, { nx, a, b });
+            if (neg) {
+                WriteClause(matr, { x, na });
+                WriteClause(matr, { x, nb });
+            }
+            break;
+        case '>': // x ~ -a | b
+            if (pos)
+                WriteClause(matr, { nx, na, b });
+            if (neg) {
+                WriteClause(matr, { x, a });
+                WriteClause(matr, { x, nb });
+            }
+            break;
+        case '~': // x ~ (a ~ b)
+            if (pos) {
+                WriteClause(matr, { nx, na, b });
+                WriteClause(matr, { nx, a, nb });
+            }
+            if (neg) {
+                WriteClause(matr, { x, a, b });
+                WriteClause(matr, { x, na, nb });
+            }
+            break;
+    }
+    return x;
+}
+
+// Construct an equisatisfiable set of disjuncts by the Tseitin transformation.
+// Each binary operation gets an auxiliary variable standing for its subformula;
+// the formula holds iff the variable of its root holds
+int Tseitin(Queue expr, ClauseSet& matr, Set vars, unsigned& nextVar) {
+    std::vector<FormulaNode> tree = FormulaTree(expr);
+    std::map<Token, unsigned> index;
+    unsigned j = 0;
+    for (Set::const_iterator k = vars.begin(); k != vars.end(); k++)
+        index[*k] = j++;
+    int before = matr.count();
+    unsigned first = nextVar;
+    int root = TseitinNode(tree, (int) tree.size() - 1, POSITIVE, matr, index, nextVar);
+    for (unsigned v = first; v < nextVar; v++)
+        matr.names[v] = "t" + std::to_string(v - vars.size() + 1);
+    WriteClause(matr, std::vector<int>(1, root));
+    return matr.count() - before;
+}
+
+
+// Check if the resolvent is empty 
+bool EmptySequence(ClauseView a) { 
+    return a.size == 0;
+}
+
+// Check for equality of disjuncts 
+bool EqvivArr(ClauseView a, ClauseView b) { 
+    return a.size == b.size && std::equal(a.begin(), a.end(), b.begin());
+}
+
+// Number of literals in the disjunct
+unsigned ClauseWeight(ClauseView a) {
+    return a.size;
+}
+
+// Does the disjunct contain a variable together with its negation?
+// They would be next to each other
+bool Tautology(ClauseView a) {
+    for (unsigned i = 1; i < a.size; i++)
+        if (a.lits[i] == complement(a.lits[i - 1]))
+            return true;
+    return false;
+}
+
+// Signature of the disjunct: a bit for each of its literals
+// (the literals a word apart share a bit)
+Word ClauseSignature(ClauseView a) {
+    Word sig = 0;
+    for (unsigned i = 0; i < a.size; i++)
+        sig |= (Word) 1 << (a.lits[i] % 64);
+    return sig;
+}
+
+// Is the disjunct a a subset of the disjunct b?
+// Both are walked through at once in the order of the literals
+bool Subsumes(ClauseView a, ClauseView b) {
+    if (a.size > b.size)
+        return false;
+    unsigned j = 0;
+    for (unsigned i = 0; i < a.size; i++) {
+        while (j < b.size && b.lits[j] < a.lits[i])
+            j++;
+        if (j == b.size || b.lits[j] != a.lits[i])
+            return false;
+        j++;
+    }
+    return true;
+}
+
+// Search for a disjunct in use that subsumes a, return its number or -1.
+// Such a disjunct consists of literals of a, so it is found
+// in the occurrence lists of the literals of a
+int ForwardSubsumed(const ClauseSet& matr, ClauseView a) {
+    Word sig = ClauseSignature(a);
+    for (unsigned l = 0; l < a.size; l++) {
+        const std::vector<int>& occ = matr.occurs[a.lits[l]];
+        for (size_t p = 0; p < occ.size(); p++) {
+            int i = occ[p];
+            if (matr.alive[i] && (matr.sigs[i] & ~sig) == 0 && Subsumes(matr.clause(i), a))
+                return i;
+        }
+    }
+    return -1;
+}
+
+// Delete the disjuncts in use subsumed by the n-th disjunct, put their numbers into removed.
+// Such disjuncts contain every literal of it, so it is enough
+// to look through the shortest occurrence list of its literals
+void BackwardSubsume(ClauseSet& matr, int n, std::vector<int>& removed) {
+    ClauseView c = matr.clause(n);
+    removed.clear();
+    if (c.size == 0)
+        return;
+    int best = c.lits[0];
+    for (unsigned l = 1; l < c.size; l++)
+        if (matr.occurs[c.lits[l]].size() < matr.occurs[best].size())
+            best = c.lits[l];
+    Word sig = matr.sigs[n];
+    const std::vector<int>& occ = matr.occurs[best];
+    for (size_t p = 0; p < occ.size(); p++) {
+        int i = occ[p];
+        if (i != n && matr.alive[i] && (sig & ~matr.sigs[i]) == 0 && Subsumes(c, matr.clause(i))) {
+            DeleteArr(matr, i);
+            removed.push_back(i);
+        }
+    }
+}
+
+// Put the literals of the disjunct into lits
+void ClauseLiterals(ClauseView a, std::vector<int>& lits) {
+    lits.assign(a.begin(), a.end());
+}
+
+// Build the resolvent r of disjuncts a and b:
+// all their literals except the contrary pairs.
+// The literals are merged in order; the literals of a variable are next
+// to each other, so a contrary pair meets when one of them is taken
+unsigned Resolve(ClauseView a, ClauseView b, std::vector<int>& r) {
+    unsigned clashes = 0, i = 0, j = 0;
+    r.clear();
+    while (i < a.size || j < b.size) {
+        int l;
+        if (j == b.size || (i < a.size && a.lits[i] < b.lits[j]))
+            l = a.lits[i++];
+        else if (i == a.size || b.lits[j] < a.lits[i])
+            l = b.lits[j++];
+        else { // the same literal in both
+            l = a.lits[i++];
+            j++;
+        }
+        if (!r.empty() && r.back() == complement(l)) {
+            r.pop_back();
+            clashes++;
+        } else {
+            r.push_back(l);
+        }
+    }
+    return clashes;
+}
+
+// 64-bit fingerprint of a disjunct
+Word ClauseHash(ClauseView a) {
+    Word h = 0x9E3779B97F4A7C15ULL;
+    for (unsigned i = 0; i < a.size; i++) {
+        h ^= (Word) a.lits[i] + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2);
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+// Search for a disjunct in the set by its fingerprint
+bool SearchArr(const ClauseSet& matr, ClauseView a) { 
+    Word h = ClauseHash(a);
+    size_t mask = matr.table.size() - 1;
+    for (size_t i = h & mask; matr.table[i].second >= 0; i = (i + 1) & mask) {
+        if (matr.table[i].first == h && EqvivArr(matr.clause(matr.table[i].second), a)) 
+            return true;
+    }
+    return false;
+}
+
+// Put the n-th disjunct with fingerprint h into the hash table
+void InsertHash(std::vector<std::pair<Word, int> >& table, Word h, int n) {
+    size_t mask = table.size() - 1;
+    size_t i = h & mask;
+    while (table[i].second >= 0)
+        i = (i + 1) & mask;
+    table[i] = std::pair<Word, int>(h, n);
+}
+
+// Remove the n-th disjunct from the hash table,
+// moving back the following disjuncts of its probe sequence
+void EraseHash(std::vector<std::pair<Word, int> >& table, Word h, int n) {
+    size_t mask = table.size() - 1;
+    size_t i = h & mask;
+    while (table[i].second != n)
+        i = (i + 1) & mask;
+    for (size_t j = (i + 1) & mask; table[j].second >= 0; j = (j + 1) & mask) {
+        size_t home = table[j].first & mask;
+        // The disjunct at j may fill the hole at i if its home slot is not in (i, j]
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            table[i] = table[j];
+            i = j;
+        }
+    }
+    table[i] = std::pair<Word, int>(0, -1);
+}
+
+// Put the disjunct into the n-th slot, which is free,
+// and into the occurrence index and hash table
+static void placeClause(ClauseSet& matr, int n, ClauseView a) {
+    // The place of a deleted disjunct of the same length, or a new one
+    // in the last chunk (the rest of a chunk too short for it is left)
+    size_t start;
+    if (a.size < matr.freePlaces.size() && !matr.freePlaces[a.size].empty()) {
+        start = matr.freePlaces[a.size].back();
+        matr.freePlaces[a.size].pop_back();
+    } else {
+        int c = ClauseSet::chunkOf(matr.used);
+        while (a.size > 0 && ClauseSet::chunkOf(matr.used + a.size - 1) != c)
+            matr.used = ClauseSet::firstLiteral(++c);
+        while ((int) matr.chunks.size() <= c)
+            matr.chunks.push_back(std::vector<int>());
+        if (matr.chunks[c].empty())
+            matr.chunks[c].resize(CHUNK_LITERALS << c);
+        start = matr.used;
+        matr.used += a.size;
+    }
+    if (a.size > 0) {
+        int c = ClauseSet::chunkOf(start);
+        std::copy(a.begin(), a.end(), &matr.chunks[c][start - ClauseSet::firstLiteral(c)]);
+    }
+    matr.starts[n] = start;
+    matr.lengths[n] = a.size;
+    for (unsigned i = 0; i < a.size; i++)
+        matr.occurs[a.lits[i]].push_back(n);
+    matr.sigs[n] = ClauseSignature(a);
+    matr.alive[n] = 1;
+    // Keep the table at most half full
+    if (2 * (size_t) matr.count() > matr.table.size()) {
+        std::vector<std::pair<Word, int> > table(2 * matr.table.size(), std::pair<Word, int>(0, -1));
+        for (size_t i = 0; i < matr.table.size(); i++)
+            if (matr.table[i].second >= 0)
+                InsertHash(table, matr.table[i].first, matr.table[i].second);
+        matr.table.swap(table);
+    }
+    InsertHash(matr.table, ClauseHash(a), n);
+}
+
+// Take the n-th disjunct out of the hash table and give up its place;
+// the slot is left to the caller
+static void freeClause(ClauseSet& matr, int n) {
+    EraseHash(matr.table, ClauseHash(matr.clause(n)), n);
+    matr.alive[n] = 0;
+    unsigned length = matr.lengths[n];
+    if (length > 0) {
+        if (matr.freePlaces.size() <= length)
+            matr.freePlaces.resize(length + 1);
+        matr.freePlaces[length].push_back(matr.starts[n]);
+    }
+    matr.deleted++;
+}
+
+// Write to the set of disjuncts, to its occurrence index and hash table,
+// return the number of the new disjunct
+int WriteArr(ClauseSet& matr, ClauseView a) { 
+    int n;
+    bool fresh = matr.freeSlots.empty();
+    if (!fresh) { // reuse the slot of a deleted disjunct
+        n = matr.freeSlots.back();
+        matr.freeSlots.pop_back();
+    } else {
+        n = matr.slots++;
+        matr.starts.push_back(0);
+        matr.lengths.push_back(0);
+        matr.sigs.push_back(0);
+        matr.alive.push_back(0);
+        matr.ages.push_back(0);
+        matr.origins.push_back(ORIGIN_GOAL);
+        matr.steps.push_back(-1);
+    }
+    placeClause(matr, n, a);
+    matr.ages[n] = matr.clock++;
+    matr.origins[n] = ORIGIN_GOAL;
+    matr.steps[n] = -1;
+    if (matr.keepChanges) {
+        ClauseChange change = { n, false, fresh, std::vector<int>(), 0, 0, 0 };
+        matr.changes.push_back(change);
+    }
+    return n;
+}
+
+// Delete the n-th disjunct, its slot and place will be reused
+void DeleteArr(ClauseSet& matr, int n) {
+    if (matr.keepChanges) {
+        ClauseView a = matr.clause(n);
+        ClauseChange change = { n, true, false, std::vector<int>(a.begin(), a.end()),
+                                matr.ages[n], matr.origins[n], matr.steps[n] };
+        matr.changes.push_back(change);
+    }
+    freeClause(matr, n);
+    matr.freeSlots.push_back(n);
+}
+
+// Drop the numbers of deleted disjuncts from the occurrence index
+void CompactOccurs(ClauseSet& matr) {
+    for (size_t l = 0; l < matr.occurs.size(); l++) {
+        std::vector<int>& occ = matr.occurs[l];
+        size_t k = 0;
+        for (size_t p = 0; p < occ.size(); p++)
+            if (matr.alive[occ[p]] && HasLiteral(matr.clause(occ[p]), (int) l))
+                occ[k++] = occ[p];
+        occ.resize(k);
+        // A slot may have been reused by a disjunct listed here already
+        std::sort(occ.begin(), occ.end());
+        occ.erase(std::unique(occ.begin(), occ.end()), occ.end());
+    }
+    matr.deleted = 0;
+}
+
+void AddVariables(ClauseSet& matr, unsigned count) {
+    matr.countVars += count;
+    matr.names.resize(matr.countVars);
+    matr.occurs.resize(2 * matr.countVars);
+}
+
+void RemoveVariables(ClauseSet& matr, unsigned first) {
+    matr.countVars = first;
+    matr.names.resize(first);
+    matr.occurs.resize(2 * first);
+}
+
+// Each change is undone on the state it left, so the slot of a deleted
+// disjunct is the last free one again when its deletion is undone.
+// The new slots of written disjuncts are freed after the others
+void UndoChanges(ClauseSet& matr) {
+    std::vector<int> fresh;
+    for (size_t k = matr.changes.size(); k-- > 0; ) {
+        const ClauseChange& change = matr.changes[k];
+        int n = change.n;
+        if (change.deletion) {
+            matr.freeSlots.pop_back();
+            placeClause(matr, n, change.lits);
+            matr.ages[n] = change.age;
+            matr.origins[n] = change.origin;
+            matr.steps[n] = change.step;
+        } else {
+            freeClause(matr, n);
+            matr.clock--;
+            if (change.fresh)
+                fresh.push_back(n);
+            else
+                matr.freeSlots.push_back(n);
+        }
+    }
+    matr.freeSlots.insert(matr.freeSlots.end(), fresh.rbegin(), fresh.rend());
+    matr.changes.clear();
+    matr.keepChanges = false;
+}
+
+// Number of bytes taken by the set of disjuncts
+size_t MemoryUsage(const ClauseSet& matr) {
+    size_t bytes = 0;
+    for (size_t c = 0; c < matr.chunks.size(); c++)
+        bytes += matr.chunks[c].capacity() * sizeof(int);
+    for (size_t l = 0; l < matr.occurs.size(); l++)
+        bytes += matr.occurs[l].capacity() * sizeof(int);
+    for (size_t k = 0; k < matr.freePlaces.size(); k++)
+        bytes += matr.freePlaces[k].capacity() * sizeof(size_t);
+    bytes += matr.table.capacity() * sizeof(matr.table[0]);
+    bytes += matr.sigs.capacity() * sizeof(Word) + matr.alive.capacity()
+        + matr.starts.capacity() * sizeof(size_t) + matr.lengths.capacity() * sizeof(unsigned)
+        + matr.ages.capacity() * sizeof(unsigned) + matr.freeSlots.capacity() * sizeof(int)
+        + (matr.origins.capacity() + matr.steps.capacity()) * sizeof(int);
+    return bytes;
+}
+
+// Output the disjunction of the literals in the order of the variables
+void PrintfLits(std::vector<int> lits, const std::vector<String>& names) {
+    std::sort(lits.begin(), lits.end());
+    std::cout << "(";
+    for (size_t i = 0; i < lits.size(); i++) {
+        if (lits[i] & 1)
+            std::cout << '-';
+        std::cout << names[lits[i] / 2] << " | ";
+    }
+    std::cout << "\b\b\b)";
+}
+
+// Output the disjunction 
+void PrintfArr(const ClauseSet& matr, int n) { 
+    std::vector<int> lits;
+    ClauseLiterals(matr.clause(n), lits);
+    PrintfLits(lits, matr.names);
+}
+
+// Write the literals to the proof file in DIMACS numbering
+void WriteProofLits(std::ofstream& file, const std::vector<int>& lits) {
+    for (size_t k = 0; k < lits.size(); k++)
+        file << (lits[k] & 1 ? -(lits[k] / 2 + 1) : lits[k] / 2 + 1) << ' ';
+    file << '0';
+}
+
+// Record a step of the derivation and write it to the proof file, return its number
+int AddStep(Derivation& proof, const std::vector<int>& lits, int left, int right) {
+    ProofStep ps = { lits, left, right, ORIGIN_GOAL };
+    proof.steps.push_back(ps);
+    int id = (int) proof.steps.size() - 1;
+    if (proof.file.is_open() && left >= 0) { // the input disjuncts are not written
+        if (proof.lrat)
+            proof.file << id + 1 << ' ';
+        WriteProofLits(proof.file, lits);
+        if (proof.lrat)
+            proof.file << ' ' << left + 1 << ' ' << right + 1 << " 0";
+        proof.file << '\n';
+    }
+    return id;
+}
+
+// Write the deletion of the n-th disjunct to the proof file
+void ForgetStep(Derivation& proof, const ClauseSet& matr, int n) {
+    if (!proof.file.is_open())
+        return;
+    if (proof.lrat) {
+        proof.file << proof.steps.size() << " d " << matr.steps[n] + 1 << " 0\n";
+    } else {
+        std::vector<int> lits;
+        ClauseLiterals(matr.clause(n), lits);
+        proof.file << "d ";
+        WriteProofLits(proof.file, lits);
+        proof.file << '\n';
+    }
+}
+
+// Record the disjuncts in use that have no step yet as the input steps of the derivation
+void RecordInputs(ClauseSet& matr, Derivation& proof) {
+    std::vector<int> lits;
+    for (int i = 0; i < matr.size(); i++) {
+        if (matr.alive[i] && matr.steps[i] < 0) {
+            ClauseLiterals(matr.clause(i), lits);
+            matr.steps[i] = AddStep(proof, lits, -1, -1);
+            proof.steps[matr.steps[i]].origin = matr.origins[i];
+        }
+    }
+}
+
+#ifdef _WIN32
+MappedFile::MappedFile(const String& path) : bytes(NULL), length(0), file(INVALID_HANDLE_VALUE), mapping(NULL) {
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                       FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    LARGE_INTEGER size;
+    if (file == INVALID_HANDLE_VALUE || !GetFileSizeEx(file, &size)) {
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+        throw String("Cannot open the file ") + path;
+    }
+    length = (size_t) size.QuadPart;
+    if (length == 0) // an empty file cannot be mapped
+        return;
+    mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping)
+        bytes = (const char*) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!bytes) {
+        if (mapping)
+            CloseHandle(mapping);
+        CloseHandle(file);
+        throw String("Cannot map the file ") + path;
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (bytes)
+        UnmapViewOfFile(bytes);
+    if (mapping)
+        CloseHandle(mapping);
+    CloseHandle(file);
+}
+#else
+MappedFile::MappedFile(const String& path) : bytes(NULL), length(0) {
+    int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0)
+            close(fd);
+        throw String("Cannot open the file ") + path;
+    }
+    length = (size_t) st.st_size;
+    if (length > 0) { // an empty file cannot be mapped
+        void* p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            throw String("Cannot map the file ") + path;
+        }
+        madvise(p, length, MADV_SEQUENTIAL);
+        bytes = (const char*) p;
+    }
+    close(fd); // the mapping stays valid
+}
+
+MappedFile::~MappedFile() {
+    if (bytes)
+        munmap((void*) bytes, length);
+}
+#endif
+
+// Read a decimal integer with an optional minus at p, move p past it
+static long long readDimacsNumber(const char*& p, const char* end) {
+    bool negative = p < end && *p == '-';
+    if (negative)
+        p++;
+    if (p == end || *p < '0' || *p > '9')
+        throw String("Wrong number in the DIMACS file");
+    long long x = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; p++) {
+        x = x * 10 + (*p - '0');
+        if (x > INT32_MAX)
+            throw String("Too large number in the DIMACS file");
+    }
+    return negative ? -x : x;
+}
+
+static void skipDimacsLine(const char*& p, const char* end) {
+    const char* eol = (const char*) memchr(p, '\n', end - p);
+    p = eol ? eol + 1 : end;
+}
+
+static bool isDimacsSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+ClauseSet ReadDimacs(const String& path, Derivation& proof) {
+    MappedFile file(path);
+    const char* p = file.data();
+    const char* end = p + file.size();
+
+    // Header "p cnf VARIABLES DISJUNCTS" after the comments
+    long long countVars = -1, declared = -1;
+    while (p < end) {
+        if (isDimacsSpace(*p)) {
+            p++;
+        } else if (*p == 'c') {
+            skipDimacsLine(p, end);
+        } else {
+            if (end - p < 5 || std::memcmp(p, "p cnf", 5) != 0)
+                throw String("The DIMACS file has no header \"p cnf\"");
+            p += 5;
+            while (p < end && (*p == ' ' || *p == '\t'))
+                p++;
+            countVars = readDimacsNumber(p, end);
+            while (p < end && (*p == ' ' || *p == '\t'))
+                p++;
+            declared = readDimacsNumber(p, end);
+            break;
+        }
+    }
+    if (countVars < 0 || declared < 0)
+        throw String("The DIMACS file has no header \"p cnf\"");
+
+    ClauseSet matr((unsigned) countVars);
+    for (unsigned j = 0; j < matr.countVars; j++)
+        matr.names[j] = std::to_string(j + 1);
+
+    // The literals of the disjunct being read, then in order without repetitions
+    std::vector<int> lits, ordered;
+    long long read = 0;
+    while (p < end) {
+        char c = *p;
+        if (isDimacsSpace(c)) {
+            p++;
+            continue;
+        }
+        if (c == 'c') {
+            skipDimacsLine(p, end);
+            continue;
+        }
+        if (c == '%') // the end of the SATLIB files
+            break;
+        long long x = readDimacsNumber(p, end);
+        if (x != 0) {
+            long long v = (x < 0 ? -x : x) - 1;
+            if (v >= countVars)
+                throw String("The variable ") + std::to_string(v + 1) + " is not declared in the DIMACS file";
+            lits.push_back(literal((unsigned) v, x < 0));
+            continue;
+        }
+        ordered = lits;
+        std::sort(ordered.begin(), ordered.end());
+        ordered.erase(std::unique(ordered.begin(), ordered.end()), ordered.end());
+        int step = AddStep(proof, ordered, -1, -1);
+        if (!Tautology(ordered) && !SearchArr(matr, ordered))
+            matr.steps[WriteArr(matr, ordered)] = step;
+        lits.clear();
+        read++;
+    }
+    if (!lits.empty())
+        throw String("The last disjunct of the DIMACS file is not ended by 0");
+    if (read != declared) // common in the benchmark files
+        std::cerr << "Warning: the DIMACS file declares " << declared << " disjuncts but has "
+                  << read << "\n";
+    return matr;
+}
+
+void WriteDimacs(const ClauseSet& matr, std::ostream& out, bool contradictory) {
+    for (unsigned j = 0; j < matr.countVars; j++)
+        if (matr.names[j] != std::to_string(j + 1))
+            out << "c " << j + 1 << ' ' << matr.names[j] << '\n';
+    out << "p cnf " << matr.countVars << ' ' << matr.count() + (contradictory ? 1 : 0) << '\n';
+    std::vector<int> lits;
+    for (int i = 0; i < matr.size(); i++) {
+        if (!matr.alive[i])
+            continue;
+        ClauseLiterals(matr.clause(i), lits);
+        for (size_t k = 0; k < lits.size(); k++)
+            out << (lits[k] & 1 ? -(lits[k] / 2 + 1) : lits[k] / 2 + 1) << ' ';
+        out << "0\n";
+    }
+    if (contradictory)
+        out << "0\n";
+}
+
+void PushUnprocessed(Agenda& unprocessed, const ClauseSet& matr, const ProverOptions& options, int n) {
+    unsigned w = options.selection == SELECT_WEIGHT ? ClauseWeight(matr.clause(n)) : 0;
+    unprocessed.push(Priority(w, matr.ages[n], n));
+}
+
+// Parallel given-clause loop. Each round takes PARALLEL_BATCH given disjuncts;
+// the j-th one is resolved with the processed disjuncts and the first j - 1
+// given ones. The threads only read the set of disjuncts and keep the
+// resolvents that are neither in it nor subsumed by its disjuncts, apart for
+// each given disjunct. Then the resolvents are stored by this thread in the
+// order of the given disjuncts, so the derivation does not depend on the
+// number of threads and their timing. The guard is checked by this thread only.
+// The worker threads are started once and woken for each round
+bool SaturateParallel(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+                      SearchGuard& guard, Agenda& unprocessed, std::vector<char>& isProcessed) {
+    std::vector<int> lits, removed, batch;
+    std::vector<unsigned> batchAges;
+    std::vector<int> rank; // by disjunct: its place in the batch, -1 if not given
+    std::atomic<unsigned long long> resolutions(0);
+    std::function<size_t()> memory = [&]() { return MemoryUsage(matr); };
+
+    // State of a round, set up by this thread before the workers are woken
+    std::vector<std::vector<Candidate> > found;
+    std::atomic<size_t> next(0);
+    std::atomic<bool> abort(false);
+    std::vector<char> cut;
+    unsigned round = 0, done = 0; // the current round and the workers done with it
+    bool quit = false;
+    std::mutex roundMutex;
+    std::condition_variable roundStart, roundDone;
+    // seen[i] is the stamp of the given disjunct a partner was last met for,
+    // the stamps grow from round to round so seen is never cleared
+    auto work = [&](bool main, std::vector<unsigned>& seen, unsigned r) {
+        std::vector<int> a;
+        std::vector<int> given;
+        if (seen.size() < (size_t) matr.size())
+            seen.resize(matr.size(), 0);
+        for (size_t j; (j = next++) < batch.size() && !abort; ) {
+            int g = batch[j];
+            unsigned stamp = (r - 1) * (unsigned) PARALLEL_BATCH + (unsigned) j + 1;
+            ClauseLiterals(matr.clause(g), given);
+            for (size_t l = 0; l < given.size() && !abort && !cut[j]; l++) {
+                int c = complement(given[l]);
+                const std::vector<int>& occ = matr.occurs[c];
+                for (size_t p = 0; p < occ.size(); p++) {
+                    int i = occ[p];
+                    if (!(isProcessed[i] || (rank[i] >= 0 && rank[i] < (int) j)) || !matr.alive[i]
+                        || seen[i] == stamp || !HasLiteral(matr.clause(i), c))
+                        continue;
+                    seen[i] = stamp;
+                    if (abort || (main && guard.stop(matr.count(), resolutions, memory))) {
+                        abort = true;
+                        break;
+                    }
+                    resolutions++;
+                    if (Resolve(matr.clause(i), matr.clause(g), a) != 1)
+                        continue;
+                    if (!EmptySequence(a)
+                        && (SearchArr(matr, a) || ForwardSubsumed(matr, a) >= 0))
+                        continue;
+                    Candidate cand = { a, i, g, matr.ages[i], matr.ages[g] };
+                    found[j].push_back(cand);
+                    if (Subsumes(a, matr.clause(g))) {
+                        cut[j] = 1; // the given disjunct is subsumed by its resolvent
+                        break;
+                    }
+                }
+            }
+        }
+    };
+    // The workers live as long as the loop and wait for each round
+    struct Pool {
+        std::vector<std::thread> threads;
+        std::function<void()> stop;
+        ~Pool() {
+            stop();
+            for (size_t t = 0; t < threads.size(); t++)
+                threads[t].join();
+        }
+    } pool;
+    pool.stop = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(roundMutex);
+            quit = true;
+        }
+        roundStart.notify_all();
+    };
+    for (unsigned t = 1; t < options.threads; t++) {
+        pool.threads.push_back(std::thread([&]() {
+            std::vector<unsigned> seen;
+            unsigned r = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(roundMutex);
+                    roundStart.wait(lock, [&]() { return quit || round != r; });
+                    if (quit)
+                        return;
+                    r = round;
+                }
+                work(false, seen, r);
+                {
+                    std::lock_guard<std::mutex> lock(roundMutex);
+                    done++;
+                }
+                roundDone.notify_one();
+            }
+        }));
+    }
+    std::vector<unsigned> seen; // of this thread
+
+    while (!unprocessed.empty()) {
+        batch.clear();
+        batchAges.clear();
+        while (batch.size() < PARALLEL_BATCH && !unprocessed.empty()) {
+            int g = std::get<2>(unprocessed.top());
+            unsigned age = std::get<1>(unprocessed.top());
+            unprocessed.pop();
+            if (!matr.alive[g] || matr.ages[g] != age)
+                continue;
+            if (EmptySequence(matr.clause(g))) {
+                proof.empty = matr.steps[g];
+                return true;
+            }
+            batch.push_back(g);
+            batchAges.push_back(age);
+        }
+        if (batch.empty())
+            break;
+        if (matr.deleted > matr.count())
+            CompactOccurs(matr);
+        rank.resize(matr.size(), -1);
+        for (size_t j = 0; j < batch.size(); j++)
+            rank[batch[j]] = (int) j;
+
+        found.assign(batch.size(), std::vector<Candidate>());
+        cut.assign(batch.size(), 0);
+        next = 0;
+        abort = false;
+        {
+            std::lock_guard<std::mutex> lock(roundMutex);
+            round++;
+            done = 0;
+        }
+        roundStart.notify_all();
+        work(true, seen, round);
+        {
+            std::unique_lock<std::mutex> lock(roundMutex);
+            while (done < options.threads - 1) { // the guard is still watched
+                if (!abort && guard.stop(matr.count(), resolutions, memory))
+                    abort = true;
+                roundDone.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+        // The given disjuncts of a stopped round stay unprocessed, so the loop may go on
+        auto giveBack = [&]() {
+            for (size_t j = 0; j < batch.size(); j++)
+                if (matr.alive[batch[j]] && matr.ages[batch[j]] == batchAges[j])
+                    PushUnprocessed(unprocessed, matr, options, batch[j]);
+        };
+        if (abort) {
+            giveBack();
+            return false;
+        }
+
+        // Store the resolvents whose parents are still in use. They were checked
+        // against the set of disjuncts before the round, so only the resolvents
+        // of this round are looked through for subsumption
+        std::vector<int> stored;
+        for (size_t j = 0; j < batch.size(); j++) {
+            if (matr.deleted > matr.count())
+                CompactOccurs(matr);
+            for (size_t k = 0; k < found[j].size(); k++) {
+                const Candidate& cand = found[j][k];
+                if (guard.stop(matr.count(), resolutions, memory)) {
+                    giveBack();
+                    return false;
+                }
+                if (!matr.alive[cand.left] || matr.ages[cand.left] != cand.leftAge
+                    || !matr.alive[cand.right] || matr.ages[cand.right] != cand.rightAge)
+                    continue;
+                int left = matr.steps[cand.left], right = matr.steps[cand.right];
+                if (EmptySequence(cand.a)) {
+                    proof.empty = AddStep(proof, std::vector<int>(), left, right);
+                    return true;
+                }
+                Word sig = ClauseSignature(cand.a);
+                bool subsumed = false;
+                for (size_t q = 0; q < stored.size() && !subsumed; q++) {
+                    int i = stored[q];
+                    subsumed = matr.alive[i] && (matr.sigs[i] & ~sig) == 0
+                        && Subsumes(matr.clause(i), cand.a);
+                }
+                if (subsumed)
+                    continue;
+                ClauseLiterals(cand.a, lits);
+                int id = AddStep(proof, lits, left, right);
+                int origin = matr.origins[cand.right] == ORIGIN_GOAL ? ORIGIN_GOAL : matr.origins[cand.left];
+                int r = WriteArr(matr, cand.a);
+                matr.steps[r] = id;
+                matr.origins[r] = origin;
+                stored.push_back(r);
+                BackwardSubsume(matr, r, removed);
+                for (size_t q = 0; q < removed.size(); q++)
+                    ForgetStep(proof, matr, removed[q]);
+                if (r >= (int) isProcessed.size())
+                    isProcessed.resize(r + 1, 0);
+                isProcessed[r] = 0;
+                PushUnprocessed(unprocessed, matr, options, r);
+            }
+        }
+        // A given disjunct left before all its partners is given again if it is still in use
+        for (size_t j = 0; j < batch.size(); j++) {
+            rank[batch[j]] = -1;
+            if (!matr.alive[batch[j]] || matr.ages[batch[j]] != batchAges[j])
+                continue;
+            if (cut[j])
+                PushUnprocessed(unprocessed, matr, options, batch[j]);
+            else
+                isProcessed[batch[j]] = 1;
+        }
+    }
+    return false;
+}
+
+// Resolution method (given-clause loop).
+// The disjuncts are split into processed and unprocessed ones.
+// At each step the best unprocessed disjunct is selected as the given one,
+// resolved with every processed disjunct containing a literal contrary
+// to one of its own (found by the occurrence index)
+// and moved to the processed ones; the new resolvents become unprocessed.
+// So every pair is resolved once.
+// A resolvent subsumed by a disjunct in use is dropped (forward subsumption),
+// and the disjuncts it subsumes are deleted (backward subsumption).
+// With the set of support only the disjuncts depending on the negated consequence
+// are selected, the premises are processed from the start.
+// Nothing is printed during the search: the parents of each resolvent are
+// recorded in proof (and streamed to its proof file)
+bool MethodResolution(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+                      SearchGuard& guard) { 
+    if (options.restriction == RESOLVE_HYPER)
+        return HyperResolution(matr, options, proof, guard);
+    if (options.restriction == RESOLVE_LINEAR)
+        return LinearResolution(matr, options, proof, guard);
+    std::vector<char> isProcessed(matr.size(), 0);
+    Agenda unprocessed;
+    RecordInputs(matr, proof);
+    for (int i = 0; i < matr.size(); i++) {
+        if (!matr.alive[i])
+            continue;
+        if (Tautology(matr.clause(i))) {
+            ForgetStep(proof, matr, i);
+            DeleteArr(matr, i); // a tautology gives nothing
+        } else if (options.setOfSupport && matr.origins[i] != ORIGIN_GOAL) {
+            isProcessed[i] = 1;
+        } else {
+            PushUnprocessed(unprocessed, matr, options, i);
+        }
+    }
+    if (options.threads > 1)
+        return SaturateParallel(matr, options, proof, guard, unprocessed, isProcessed);
+    return Saturate(matr, options, proof, guard, unprocessed, isProcessed);
+}
+
+bool Saturate(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+              SearchGuard& guard, Agenda& unprocessed, std::vector<char>& isProcessed) {
+    std::vector<int> a;
+    std::vector<int> lits, removed;
+    std::vector<unsigned> seen(isProcessed.size(), 0); // the step a partner was last met at
+    unsigned step = 0;
+    unsigned long long resolutions = 0;
+    std::function<size_t()> memory = [&]() { return MemoryUsage(matr); };
+    bool ordered = options.restriction == RESOLVE_ORDERED;
+    std::vector<unsigned> ranks;
+    std::vector<int> maxLit; // by processed disjunct: its greatest literal
+    if (ordered) {
+        ranks = VariableRanks(matr, options.order);
+        maxLit.resize(matr.size(), -1);
+        for (int i = 0; i < matr.size(); i++) // the loop may go on after a stop
+            if (matr.alive[i] && isProcessed[i])
+                maxLit[i] = MaxLiteral(matr.clause(i), ranks);
+    }
+
+    while (!unprocessed.empty()) { 
+        int g = std::get<2>(unprocessed.top());
+        unsigned age = std::get<1>(unprocessed.top());
+        unprocessed.pop();
+        if (!matr.alive[g] || matr.ages[g] != age)
+            continue;
+        if (EmptySequence(matr.clause(g))) {
+            proof.empty = matr.steps[g];
+            return true;
+        }
+        if (matr.deleted > matr.count())
+            CompactOccurs(matr);
+        step++;
+        std::vector<int> given;
+        ClauseLiterals(matr.clause(g), given);
+        if (ordered) { // only the greatest literals are resolved on
+            maxLit.resize(matr.size(), -1);
+            maxLit[g] = MaxLiteral(matr.clause(g), ranks);
+            given.assign(1, maxLit[g]);
+        }
+        for (size_t l = 0; l < given.size() && matr.alive[g]; l++) {
+            int c = complement(given[l]);
+            // The index may grow while the partners are being resolved
+            for (size_t p = 0; p < matr.occurs[c].size(); p++) { 
+                if (!matr.alive[g])
+                    break; // the given disjunct is subsumed by one of its resolvents
+                int i = matr.occurs[c][p];
+                if (!isProcessed[i] || !matr.alive[i] || seen[i] == step
+                    || (ordered && maxLit[i] != c) || !HasLiteral(matr.clause(i), c))
+                    continue;
+                seen[i] = step;
+                if (guard.stop(matr.count(), resolutions++, memory)) {
+                    PushUnprocessed(unprocessed, matr, options, g); // to go on later
+                    return false;
+                }
+                // A resolvent on more than one contrary pair is a tautology
+                if (Resolve(matr.clause(i), matr.clause(g), a) != 1)
+                    continue;
+                if (EmptySequence(a)) {
+                    proof.empty = AddStep(proof, std::vector<int>(), matr.steps[i], matr.steps[g]);
+                    return true;
+                }
+                if (!SearchArr(matr, a) && ForwardSubsumed(matr, a) < 0) { 
+                    ClauseLiterals(a, lits);
+                    int id = AddStep(proof, lits, matr.steps[i], matr.steps[g]);
+                    int origin = matr.origins[g] == ORIGIN_GOAL ? ORIGIN_GOAL : matr.origins[i];
+                    int r = WriteArr(matr, a); 
+                    matr.steps[r] = id;
+                    matr.origins[r] = origin;
+                    BackwardSubsume(matr, r, removed);
+                    for (size_t k = 0; k < removed.size(); k++)
+                        ForgetStep(proof, matr, removed[k]);
+                    if (r == (int) isProcessed.size()) {
+                        isProcessed.push_back(0);
+                        seen.push_back(0);
+                    }
+                    isProcessed[r] = 0;
+                    PushUnprocessed(unprocessed, matr, options, r);
+                }
+            }
+        }
+        isProcessed[g] = 1;
+    }
+    return false;
+}
+
+// Listed variables are greater than the others, the first one is the greatest
+std::vector<unsigned> VariableRanks(const ClauseSet& matr, const String& order) {
+    std::vector<unsigned> ranks(matr.countVars);
+    for (unsigned v = 0; v < matr.countVars; v++)
+        ranks[v] = v;
+    std::vector<String> listed;
+    for (size_t from = 0; from < order.size(); ) {
+        size_t to = order.find(',', from);
+        if (to == String::npos)
+            to = order.size();
+        listed.push_back(order.substr(from, to - from));
+        from = to + 1;
+    }
+    for (size_t k = 0; k < listed.size(); k++) {
+        unsigned v = 0;
+        while (v < matr.countVars && matr.names[v] != listed[k])
+            v++;
+        if (v == matr.countVars)
+            throw String("Unknown variable in the order: ") + listed[k];
+        ranks[v] = matr.countVars + (unsigned) (listed.size() - k);
+    }
+    return ranks;
+}
+
+int MaxLiteral(ClauseView a, const std::vector<unsigned>& ranks) {
+    int best = -1;
+    for (unsigned i = 0; i < a.size; i++)
+        if (best < 0 || ranks[a.lits[i] / 2] > ranks[best / 2])
+            best = a.lits[i];
+    return best;
+}
+
+bool Positive(ClauseView a) {
+    for (unsigned i = 0; i < a.size; i++)
+        if (a.lits[i] & 1)
+            return false;
+    return true;
+}
+
+// Given-clause loop over the electrons; the nuclei are all the other disjuncts
+// in use. A nucleus with the complement of a literal of the given electron is
+// resolved with every choice of processed electrons for its negative literals
+// in which the given electron takes part. The hyperresolvent is recorded as a
+// chain of binary resolutions: the next electron is one that clashes with the
+// rest of the nucleus on its own literal only. If there is no such order, the
+// electrons contain each other's literals in a cycle, and the hyperresolvent
+// is subsumed by one of them
+bool HyperResolution(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+                     SearchGuard& guard) {
+    std::vector<int> a, b;
+    std::vector<int> lits, removed, given, negs;
+    std::vector<char> isProcessed(matr.size(), 0); // processed electrons
+    std::vector<unsigned> seen(matr.size(), 0);     // the step a nucleus was last met at
+    unsigned step = 0;
+    unsigned long long resolutions = 0;
+    std::function<size_t()> memory = [&]() { return MemoryUsage(matr); };
+    auto inUse = [&](int n, unsigned age) { return matr.alive[n] && matr.ages[n] == age; };
+
+    Agenda unprocessed;
+    RecordInputs(matr, proof);
+    for (int i = 0; i < matr.size(); i++) {
+        if (!matr.alive[i])
+            continue;
+        if (Tautology(matr.clause(i))) {
+            ForgetStep(proof, matr, i);
+            DeleteArr(matr, i);
+        } else if (Positive(matr.clause(i))) {
+            PushUnprocessed(unprocessed, matr, options, i);
+        }
+    }
+
+    while (!unprocessed.empty()) {
+        int g = std::get<2>(unprocessed.top());
+        unsigned gAge = std::get<1>(unprocessed.top());
+        unprocessed.pop();
+        if (!inUse(g, gAge))
+            continue;
+        if (EmptySequence(matr.clause(g))) {
+            proof.empty = matr.steps[g];
+            return true;
+        }
+        if (matr.deleted > matr.count())
+            CompactOccurs(matr);
+        step++;
+        ClauseLiterals(matr.clause(g), given);
+        for (size_t l = 0; l < given.size() && inUse(g, gAge); l++) {
+            std::vector<int> nuclei = ClausesWith(matr, complement(given[l]));
+            for (size_t m = 0; m < nuclei.size() && inUse(g, gAge); m++) {
+                int n = nuclei[m];
+                // A slot freed by subsumption may hold another disjunct by now
+                if (seen[n] == step || !matr.alive[n]
+                    || !HasLiteral(matr.clause(n), complement(given[l])))
+                    continue;
+                seen[n] = step;
+                unsigned nAge = matr.ages[n];
+                // The electrons for each negative literal of the nucleus
+                ClauseLiterals(matr.clause(n), lits);
+                negs.clear();
+                for (size_t k = 0; k < lits.size(); k++)
+                    if (lits[k] & 1)
+                        negs.push_back(lits[k]);
+                if (negs.empty())
+                    continue;
+                std::vector<std::vector<std::pair<int, unsigned> > > sats(negs.size());
+                bool complete = true;
+                for (size_t q = 0; q < negs.size() && complete; q++) {
+                    std::vector<int> with = ClausesWith(matr, complement(negs[q]));
+                    for (size_t k = 0; k < with.size(); k++) {
+                        int e = with[k];
+                        if (e == g || (e < (int) isProcessed.size() && isProcessed[e]))
+                            sats[q].push_back(std::make_pair(e, matr.ages[e]));
+                    }
+                    complete = !sats[q].empty();
+                }
+                if (!complete)
+                    continue;
+
+                // Depth-first choice of the electrons. partial[q] is the nucleus without
+                // its negative literals joined with the electrons chosen before the q-th
+                // one (without their literals resolved on); it is a part of the
+                // hyperresolvent, so the choice is dropped once partial[q] is subsumed
+                size_t k = negs.size();
+                std::vector<std::vector<int> > partial(k + 1);
+                for (size_t j = 0; j < lits.size(); j++)
+                    if (!(lits[j] & 1))
+                        partial[0].push_back(lits[j]);
+                std::vector<char> usesGiven(k + 1, 0), givenLater(k + 1, 0);
+                for (size_t q = k; q-- > 0; ) {
+                    givenLater[q] = givenLater[q + 1];
+                    for (size_t j = 0; j < sats[q].size(); j++)
+                        givenLater[q] = givenLater[q] || sats[q][j].first == g;
+                }
+                std::vector<size_t> pick(k, 0), order;
+                std::vector<int> chosen(k);
+                for (size_t q = 0; inUse(g, gAge) && inUse(n, nAge); ) {
+                    if (pick[q] == sats[q].size()) { // back to the previous literal
+                        if (q == 0)
+                            break;
+                        pick[--q]++;
+                        continue;
+                    }
+                    int e = sats[q][pick[q]].first;
+                    usesGiven[q + 1] = usesGiven[q] || e == g;
+                    if (!inUse(e, sats[q][pick[q]].second) || (!usesGiven[q + 1] && !givenLater[q + 1])) {
+                        pick[q]++;
+                        continue;
+                    }
+                    if (guard.stop(matr.count(), resolutions++, memory))
+                        return false;
+                    // The literal resolved on stays only if partial[q] has it
+                    ClauseView electron = matr.clause(e);
+                    int v = complement(negs[q]);
+                    partial[q + 1].clear();
+                    std::set_union(partial[q].begin(), partial[q].end(), electron.begin(), electron.end(),
+                                   std::back_inserter(partial[q + 1]));
+                    if (!std::binary_search(partial[q].begin(), partial[q].end(), v))
+                        partial[q + 1].erase(std::lower_bound(partial[q + 1].begin(), partial[q + 1].end(), v));
+                    if (ForwardSubsumed(matr, partial[q + 1]) >= 0) {
+                        pick[q]++;
+                        continue;
+                    }
+                    if (q + 1 < k) {
+                        pick[++q] = 0;
+                        continue;
+                    }
+                    for (size_t j = 0; j < k; j++)
+                        chosen[j] = sats[j][pick[j]].first;
+                    pick[q]++;
+                    // Order of the binary resolutions
+                    ClauseLiterals(matr.clause(n), a);
+                    std::vector<char> done(k, 0);
+                    order.clear();
+                    for (size_t r = 0; r < k; r++) {
+                        size_t j = 0;
+                        while (j < k && (done[j] || Resolve(a,
+                               matr.clause(chosen[j]), b) != 1))
+                            j++;
+                        if (j == k)
+                            break;
+                        done[j] = 1;
+                        order.push_back(j);
+                        a.swap(b);
+                    }
+                    if (order.size() < k)
+                        continue;
+                    bool empty = EmptySequence(a);
+                    if (!empty && SearchArr(matr, a))
+                        continue;
+                    // Record the chain
+                    ClauseLiterals(matr.clause(n), b);
+                    int id = matr.steps[n];
+                    int origin = matr.origins[n];
+                    for (size_t j = 0; j < order.size(); j++) {
+                        int s = chosen[order[j]];
+                        std::vector<int> r;
+                        Resolve(b, matr.clause(s), r);
+                        b.swap(r);
+                        ClauseLiterals(b, lits);
+                        id = AddStep(proof, lits, matr.steps[s], id);
+                        if (matr.origins[s] == ORIGIN_GOAL)
+                            origin = ORIGIN_GOAL;
+                    }
+                    if (empty) {
+                        proof.empty = id;
+                        return true;
+                    }
+                    int r = WriteArr(matr, a);
+                    matr.steps[r] = id;
+                    matr.origins[r] = origin;
+                    BackwardSubsume(matr, r, removed);
+                    for (size_t j = 0; j < removed.size(); j++)
+                        ForgetStep(proof, matr, removed[j]);
+                    if (r >= (int) isProcessed.size()) {
+                        isProcessed.resize(r + 1, 0);
+                        seen.resize(r + 1, 0);
+                    }
+                    isProcessed[r] = 0;
+                    PushUnprocessed(unprocessed, matr, options, r);
+                }
+            }
+        }
+        if (inUse(g, gAge))
+            isProcessed[g] = 1;
+    }
+    return false;
+}
+
+// The centers are kept apart from the set of disjuncts, which holds the input
+// ones only, and are chosen like the given disjuncts. A resolvent subsumed by
+// one of its ancestors is dropped (t-linear resolution), and so is a resolvent
+// that is already a center of another branch, so the search is finite.
+// Starting from the consequence, the search may miss the contradiction of the
+// premises themselves, so running out of centers proves nothing
+bool LinearResolution(ClauseSet& matr, const ProverOptions& options, Derivation& proof,
+                      SearchGuard& guard) {
+    std::vector<int> a;
+    std::vector<int> lits;
+    std::vector<LinearCenter> centers;
+    unsigned long long resolutions = 0;
+    size_t centerBytes = 0;
+    std::function<size_t()> memory = [&]() { return MemoryUsage(matr) + centerBytes; };
+    Agenda agenda;
+    std::multimap<Word, int> known; // fingerprints of the centers
+    auto isKnown = [&](ClauseView c) {
+        auto range = known.equal_range(ClauseHash(c));
+        for (auto it = range.first; it != range.second; ++it)
+            if (EqvivArr(c, centers[it->second].a))
+                return true;
+        return false;
+    };
+    auto push = [&](ClauseView c, int id, int parent) {
+        LinearCenter center = { std::vector<int>(c.begin(), c.end()), id, parent };
+        centers.push_back(center);
+        centerBytes += sizeof(LinearCenter) + c.size * sizeof(int);
+        known.insert(std::make_pair(ClauseHash(c), (int) centers.size() - 1));
+        unsigned w = options.selection == SELECT_WEIGHT ? ClauseWeight(c) : 0;
+        agenda.push(Priority(w, (unsigned) centers.size() - 1, (int) centers.size() - 1));
+    };
+    RecordInputs(matr, proof);
+    for (int i = 0; i < matr.size(); i++) {
+        if (!matr.alive[i])
+            continue;
+        if (Tautology(matr.clause(i))) {
+            ForgetStep(proof, matr, i);
+            DeleteArr(matr, i);
+        } else if (matr.origins[i] == ORIGIN_GOAL) {
+            if (EmptySequence(matr.clause(i))) {
+                proof.empty = matr.steps[i];
+                return true;
+            }
+            if (!isKnown(matr.clause(i)))
+                push(matr.clause(i), matr.steps[i], -1);
+        }
+    }
+
+    while (!agenda.empty()) {
+        int n = std::get<2>(agenda.top());
+        agenda.pop();
+        std::vector<int> center = centers[n].a; // the centers may move while growing
+        int centerStep = centers[n].step;
+        // Resolve with a side disjunct, return 1 for the empty resolvent, -1 if stopped
+        auto side = [&](ClauseView s, int sideStep) {
+            if (guard.stop(centers.size(), resolutions++, memory))
+                return -1;
+            if (Resolve(center, s, a) != 1)
+                return 0;
+            if (EmptySequence(a)) {
+                proof.empty = AddStep(proof, std::vector<int>(), sideStep, centerStep);
+                return 1;
+            }
+            for (int k = n; k >= 0; k = centers[k].parent)
+                if (Subsumes(centers[k].a, a))
+                    return 0;
+            if (isKnown(a))
+                return 0;
+            ClauseLiterals(a, lits);
+            push(a, AddStep(proof, lits, sideStep, centerStep), n);
+            return 0;
+        };
+        std::vector<int> own;
+        ClauseLiterals(center, own);
+        for (size_t l = 0; l < own.size(); l++) {
+            int c = complement(own[l]);
+            std::vector<int> inputs = ClausesWith(matr, c);
+            for (size_t k = 0; k < inputs.size(); k++) {
+                int res = side(matr.clause(inputs[k]), matr.steps[inputs[k]]);
+                if (res != 0)
+                    return res > 0;
+            }
+            for (int k = centers[n].parent; k >= 0; k = centers[k].parent) {
+                if (!HasLiteral(centers[k].a, c))
+                    continue;
+                std::vector<int> ancestor = centers[k].a;
+                int res = side(ancestor, centers[k].step);
+                if (res != 0)
+                    return res > 0;
+            }
+        }
+    }
+    return false;
+}
+
+// Extend the assignment to the removed disjuncts: going backwards,
+// a disjunct that is false gets its literal made true
+void ExtendModel(const Reconstruction& rec, std::vector<int>& values) {
+    for (size_t k = rec.size(); k-- > 0; ) {
+        const std::vector<int>& lits = rec[k].second;
+        bool satisfied = false;
+        for (size_t j = 0; j < lits.size() && !satisfied; j++)
+            satisfied = values[lits[j] / 2] == !(lits[j] & 1);
+        if (!satisfied)
+            values[rec[k].first / 2] = !(rec[k].first & 1);
+    }
+}
+
+// Remove the n-th disjunct, remembering that the literal l satisfies it
+void RemoveClause(ClauseSet& matr, Derivation& proof, Reconstruction& rec, int n, int l) {
+    std::vector<int> lits;
+    ClauseLiterals(matr.clause(n), lits);
+    rec.push_back(std::make_pair(l, lits));
+    ForgetStep(proof, matr, n);
+    DeleteArr(matr, n);
+}
+
+// Numbers of the disjuncts in use containing the literal l
+std::vector<int> ClausesWith(const ClauseSet& matr, int l) {
+    std::vector<int> res;
+    const std::vector<int>& occ = matr.occurs[l];
+    for (size_t p = 0; p < occ.size(); p++)
+        if (matr.alive[occ[p]] && HasLiteral(matr.clause(occ[p]), l))
+            res.push_back(occ[p]);
+    std::sort(res.begin(), res.end());
+    res.erase(std::unique(res.begin(), res.end()), res.end());
+    return res;
+}
+
+// Unit propagation of the literal l over the disjuncts in use,
+// assign holds the values of the literals (-1 unassigned, 0, 1 by variable),
+// trail gets the implied literals with the disjuncts implying them.
+// Return the number of a falsified disjunct or -1
+int ProbeLiteral(const ClauseSet& matr, int l, std::vector<int>& assign,
+                 std::vector<std::pair<int, int> >& trail) {
+    std::vector<int> lits;
+    trail.assign(1, std::make_pair(l, -1));
+    assign[l / 2] = !(l & 1);
+    for (size_t q = 0; q < trail.size(); q++) {
+        std::vector<int> cand = ClausesWith(matr, complement(trail[q].first));
+        for (size_t p = 0; p < cand.size(); p++) {
+            ClauseLiterals(matr.clause(cand[p]), lits);
+            int free = -1, freeCount = 0;
+            bool satisfied = false;
+            for (size_t k = 0; k < lits.size() && !satisfied; k++) {
+                int v = assign[lits[k] / 2];
+                if (v < 0) {
+                    free = lits[k];
+                    freeCount++;
+                } else if (v == !(lits[k] & 1)) {
+                    satisfied = true;
+                }
+            }
+            if (satisfied || freeCount > 1)
+                continue;
+            if (freeCount == 0)
+                return cand[p];
+            assign[free / 2] = !(free & 1);
+            trail.push_back(std::make_pair(free, cand[p]));
+        }
+    }
+    return -1;
+}
+
+// Simplify the set of disjuncts before the proof:
+// - tautologies are removed;
+// - unit propagation: a unit disjunct l removes the disjuncts containing l
+//   and the literal -l from the others (by resolution with it), until no unit is left;
+// - pure literal elimination: a literal whose negation occurs nowhere
+//   can be made true, removing the disjuncts containing it;
+// - failed literal probing: if propagation of l falsifies a disjunct,
+//   the unit -l is derived (by resolving the conflict with the reasons back to l).
+// The derived disjuncts are recorded in proof, the removed ones in rec.
+// The guard is asked before each unit, variable and probe; a stopped pass
+// leaves a consistent set and returns false
+bool Preprocess(ClauseSet& matr, Derivation& proof, Reconstruction& rec, PreprocessStats& stats,
+                SearchGuard& guard) {
+    stats.clauses = stats.variables = stats.units = stats.pure = stats.failed = 0;
+    // The step budget is left to the search
+    std::function<size_t()> memory = [&]() { return MemoryUsage(matr); };
+    auto stop = [&]() { return guard.stop(matr.count(), 0, memory); };
+    std::vector<int> a, cur;
+    std::vector<int> lits;
+    int before = matr.count();
+    std::vector<char> occurred(matr.countVars, 0);
+    // Count what has been removed
+    auto finish = [&]() {
+        stats.clauses = before - matr.count();
+        for (unsigned v = 0; v < matr.countVars; v++)
+            if (occurred[v] && ClausesWith(matr, literal(v, false)).empty()
+                && ClausesWith(matr, literal(v, true)).empty())
+                stats.variables++;
+    };
+    RecordInputs(matr, proof);
+    for (int i = 0; i < matr.size(); i++) {
+        if (!matr.alive[i])
+            continue;
+        ClauseLiterals(matr.clause(i), lits);
+        for (size_t k = 0; k < lits.size(); k++)
+            occurred[lits[k] / 2] = 1;
+        if (Tautology(matr.clause(i))) {
+            ForgetStep(proof, matr, i);
+            DeleteArr(matr, i);
+        }
+    }
+
+    bool changed = true;
+    while (changed && !stop()) {
+        changed = false;
+        // Unit propagation
+        std::vector<int> units;
+        for (int i = 0; i < matr.size(); i++)
+            if (matr.alive[i] && ClauseWeight(matr.clause(i)) == 1)
+                units.push_back(i);
+        while (!units.empty() && !stop()) {
+            int u = units.back();
+            units.pop_back();
+            if (!matr.alive[u] || ClauseWeight(matr.clause(u)) != 1)
+                continue;
+            ClauseLiterals(matr.clause(u), lits);
+            int l = lits[0];
+            std::vector<int> sat = ClausesWith(matr, l);
+            for (size_t p = 0; p < sat.size(); p++)
+                if (sat[p] != u)
+                    RemoveClause(matr, proof, rec, sat[p], l);
+            std::vector<int> weak = ClausesWith(matr, complement(l));
+            for (size_t p = 0; p < weak.size(); p++) {
+                int i = weak[p];
+                Resolve(matr.clause(i), matr.clause(u), a);
+                ClauseLiterals(a, lits);
+                int id = AddStep(proof, lits, matr.steps[i], matr.steps[u]);
+                if (lits.empty()) {
+                    proof.empty = id;
+                    finish();
+                    return true;
                 }
-                matr++;
-                c++;
+                int origin = matr.origins[u] == ORIGIN_GOAL ? ORIGIN_GOAL : matr.origins[i];
+                ForgetStep(proof, matr, i);
+                DeleteArr(matr, i);
+                if (!SearchArr(matr, a)) {
+                    int r = WriteArr(matr, a);
+                    matr.steps[r] = id;
+                    matr.origins[r] = origin;
+                    if (lits.size() == 1)
+                        units.push_back(r);
+                }
+            }
+            // The variable of the unit occurs nowhere else now
+            RemoveClause(matr, proof, rec, u, l);
+            stats.units++;
+            changed = true;
+        }
+
+        // Pure literals
+        for (unsigned v = 0; v < matr.countVars && !stop(); v++) {
+            for (int sign = 0; sign < 2; sign++) {
+                int l = literal(v, sign);
+                std::vector<int> with = ClausesWith(matr, l);
+                if (with.empty() || !ClausesWith(matr, complement(l)).empty())
+                    continue;
+                for (size_t p = 0; p < with.size(); p++)
+                    RemoveClause(matr, proof, rec, with[p], l);
+                stats.pure++;
+                changed = true;
+            }
+        }
+        if (changed || guard.stopped != STOP_NONE)
+            continue;
+
+        // Failed literals
+        std::vector<int> assign(matr.countVars, -1);
+        std::vector<std::pair<int, int> > trail;
+        for (unsigned v = 0; v < matr.countVars && !changed && guard.stopped == STOP_NONE; v++) {
+            for (int sign = 0; sign < 2 && !changed; sign++) {
+                int l = literal(v, sign);
+                if (ClausesWith(matr, l).empty())
+                    continue;
+                if (stop())
+                    break;
+                int confl = ProbeLiteral(matr, l, assign, trail);
+                for (size_t k = 0; k < trail.size(); k++)
+                    assign[trail[k].first / 2] = -1;
+                if (confl < 0)
+                    continue;
+                // Resolve the falsified disjunct with the reasons of its literals,
+                // latest first, until only -l is left
+                ClauseLiterals(matr.clause(confl), cur);
+                int curStep = matr.steps[confl];
+                bool goal = matr.origins[confl] == ORIGIN_GOAL;
+                int origin = matr.origins[confl];
+                for (size_t k = trail.size(); k-- > 1; ) {
+                    int x = trail[k].first, reason = trail[k].second;
+                    if (!HasLiteral(cur, complement(x)))
+                        continue;
+                    Resolve(cur, matr.clause(reason), a);
+                    cur.swap(a);
+                    ClauseLiterals(cur, lits);
+                    curStep = AddStep(proof, lits, curStep, matr.steps[reason]);
+                    goal = goal || matr.origins[reason] == ORIGIN_GOAL;
+                }
+                if (EmptySequence(cur)) {
+                    proof.empty = curStep;
+                    finish();
+                    return true;
+                }
+                if (!SearchArr(matr, cur)) {
+                    int r = WriteArr(matr, cur);
+                    matr.steps[r] = curStep;
+                    matr.origins[r] = goal ? ORIGIN_GOAL : origin;
+                }
+                stats.failed++;
+                changed = true;
             }
         }
     }
-    return c; // Return the number of clauses generated
 
+    finish();
+    return false;
 }
 
+// Bounded variable elimination. Variables are taken from a queue ordered by
+// the number of resolvents on them (positive times negative occurrences);
+// an entry whose count has changed since it was queued is queued again.
+// The disjuncts of the sign with fewer occurrences are kept for the model
+// with the variable as the literal satisfying them, followed by the unit
+// of the opposite literal: going backwards, the variable is set so that
+// the other sign is true unless one of the kept disjuncts needs it.
+// The guard is asked before each candidate; a stopped pass returns false
+bool EliminateVariables(ClauseSet& matr, Derivation& proof, Reconstruction& rec, int& eliminated,
+                        SearchGuard& guard) {
+    eliminated = 0;
+    std::function<size_t()> memory = [&]() { return MemoryUsage(matr); };
+    std::vector<int> a;
+    std::vector<int> lits;
+    std::vector<char> done(matr.countVars, 0);
+    typedef std::pair<size_t, unsigned> Cost;
+    std::priority_queue<Cost, std::vector<Cost>, std::greater<Cost> > queue;
+    auto cost = [&](unsigned v) {
+        return ClausesWith(matr, literal(v, false)).size() * ClausesWith(matr, literal(v, true)).size();
+    };
+    RecordInputs(matr, proof);
+    for (unsigned v = 0; v < matr.countVars; v++)
+        queue.push(Cost(cost(v), v));
 
-// Check if the resolvent is empty 
-bool EmptySequence(int* a, unsigned countVars) { 
-    for (unsigned i = 0; i < countVars; i++)
-        if (a[i] != 1)
+    while (!queue.empty()) {
+        Cost top = queue.top();
+        queue.pop();
+        unsigned v = top.second;
+        if (done[v])
+            continue;
+        if (guard.stop(matr.count(), 0, memory))
             return false;
-    return true;
+        std::vector<int> pos = ClausesWith(matr, literal(v, false));
+        std::vector<int> neg = ClausesWith(matr, literal(v, true));
+        if (pos.empty() && neg.empty())
+            continue;
+        if (pos.size() * neg.size() != top.first) { // outdated entry
+            queue.push(Cost(pos.size() * neg.size(), v));
+            continue;
+        }
+        if (pos.size() > ELIMINATE_OCC_LIMIT && neg.size() > ELIMINATE_OCC_LIMIT)
+            continue;
+        // Resolvents on v, if there are not more of them than the disjuncts they replace
+        std::vector<std::vector<int> > resolvents;
+        std::vector<std::pair<int, int> > parents;
+        bool tooMany = false;
+        for (size_t p = 0; p < pos.size() && !tooMany; p++) {
+            for (size_t q = 0; q < neg.size() && !tooMany; q++) {
+                if (Resolve(matr.clause(pos[p]), matr.clause(neg[q]), a) != 1)
+                    continue; // a tautology
+                resolvents.push_back(a);
+                parents.push_back(std::make_pair(pos[p], neg[q]));
+                tooMany = resolvents.size() > pos.size() + neg.size();
+            }
+        }
+        if (tooMany)
+            continue;
+
+        // Record the resolvents before their parents are deleted
+        std::vector<int> ids(resolvents.size()), origins(resolvents.size());
+        for (size_t k = 0; k < resolvents.size(); k++) {
+            int p = parents[k].first, q = parents[k].second;
+            ClauseLiterals(resolvents[k], lits);
+            ids[k] = AddStep(proof, lits, matr.steps[p], matr.steps[q]);
+            if (lits.empty()) {
+                proof.empty = ids[k];
+                return true;
+            }
+            origins[k] = matr.origins[q] == ORIGIN_GOAL ? ORIGIN_GOAL : matr.origins[p];
+        }
+        // Remove the disjuncts with v, keeping the smaller side for the model
+        std::set<unsigned> touched;
+        int kept = pos.size() <= neg.size() ? literal(v, false) : literal(v, true);
+        for (int side = 0; side < 2; side++) {
+            const std::vector<int>& cl = side == 0 ? pos : neg;
+            for (size_t k = 0; k < cl.size(); k++) {
+                ClauseLiterals(matr.clause(cl[k]), lits);
+                for (size_t j = 0; j < lits.size(); j++)
+                    touched.insert(lits[j] / 2);
+                if (literal(v, side == 1) == kept) {
+                    RemoveClause(matr, proof, rec, cl[k], kept);
+                } else {
+                    ForgetStep(proof, matr, cl[k]);
+                    DeleteArr(matr, cl[k]);
+                }
+            }
+        }
+        rec.push_back(std::make_pair(complement(kept), std::vector<int>(1, complement(kept))));
+        for (size_t k = 0; k < resolvents.size(); k++) {
+            if (SearchArr(matr, resolvents[k]))
+                continue;
+            int r = WriteArr(matr, resolvents[k]);
+            matr.steps[r] = ids[k];
+            matr.origins[r] = origins[k];
+        }
+        done[v] = 1;
+        eliminated++;
+        for (std::set<unsigned>::iterator t = touched.begin(); t != touched.end(); t++)
+            if (!done[*t])
+                queue.push(Cost(cost(*t), *t));
+    }
+    return false;
 }
 
-// Check for equality of arrays 
-bool EqvivArr(int* a, int* b, unsigned countVars) { 
-    for (int i = 0; i < countVars; i++)
-        if (a[i] != b[i])
-            return false;
-    return true;
+// Bit v of the mask is the value of the v-th variable,
+// a disjunct is satisfied if one of its literals is true
+int TruthTable(const ClauseSet& matr, std::vector<int>& values, SearchGuard& guard) {
+    unsigned n = matr.countVars;
+    std::function<size_t()> memory = [&]() { return MemoryUsage(matr); };
+    for (unsigned long long mask = 0; mask >> n == 0; mask++) {
+        if (guard.stop(matr.count(), mask, memory))
+            return -1;
+        bool satisfied = true;
+        for (int i = 0; i < matr.size() && satisfied; i++) {
+            if (!matr.alive[i])
+                continue;
+            ClauseView a = matr.clause(i);
+            satisfied = false;
+            for (unsigned k = 0; k < a.size && !satisfied; k++)
+                satisfied = ((mask >> (a.lits[k] / 2)) & 1) != (unsigned) (a.lits[k] & 1);
+        }
+        if (satisfied) {
+            values.resize(n);
+            for (unsigned v = 0; v < n; v++)
+                values[v] = (mask >> v) & 1;
+            return 1;
+        }
+    }
+    return 0;
 }
 
-// Search for an array in the matrix 
-bool SearchArr(int** matr, int n, unsigned countVars, int* a) { 
-    for (int i = n - 1; i >= 0; i--) {
-        if (EqvivArr(matr[i], a, countVars)) 
-            return true;
+// Each strategy has its own guard with the budget of the options,
+// cancelled when another strategy wins or the search is cancelled by the user.
+// The set of support and linear resolution give no verdict when they
+// run out of disjuncts: they are not complete
+int Portfolio(const ClauseSet& matr, const Derivation& proof, const ProverOptions& options,
+              std::vector<PortfolioRun>& runs) {
+    runs.clear();
+    runs.push_back(PortfolioRun(STRATEGY_WEIGHT, "resolution by weight", matr));
+    runs.push_back(PortfolioRun(STRATEGY_AGE, "resolution by age", matr));
+    runs.push_back(PortfolioRun(STRATEGY_SOS, "set of support", matr));
+    runs.push_back(PortfolioRun(STRATEGY_ORDERED, "ordered resolution", matr));
+    runs.push_back(PortfolioRun(STRATEGY_HYPER, "hyperresolution", matr));
+    runs.push_back(PortfolioRun(STRATEGY_LINEAR, "linear resolution", matr));
+    runs.push_back(PortfolioRun(STRATEGY_CDCL, "CDCL", matr));
+    if (matr.countVars <= TRUTH_TABLE_VARS)
+        runs.push_back(PortfolioRun(STRATEGY_TRUTH_TABLE, "truth table", matr));
+
+    std::atomic<bool> cancel(false);
+    std::atomic<int> winner(-1);
+    std::atomic<unsigned> finished(0);
+    Budget budget = options.budget;
+    budget.cancel = &cancel;
+    budget.progress = nullptr;
+    auto run = [&](size_t k) {
+        PortfolioRun& r = runs[k];
+        SearchGuard guard(budget);
+        if (r.strategy == STRATEGY_CDCL) {
+            Solver solver(r.matr);
+            bool satisfiable = solver.solve(guard);
+            if (guard.stopped == STOP_NONE) {
+                r.verdict = !satisfiable;
+                for (unsigned v = 0; v < r.matr.countVars && satisfiable; v++)
+                    r.values.push_back(solver.value(v));
+            }
+        } else if (r.strategy == STRATEGY_TRUTH_TABLE) {
+            int found = TruthTable(r.matr, r.values, guard);
+            if (found >= 0)
+                r.verdict = !found;
+        } else {
+            ProverOptions opts = options;
+            opts.selection = r.strategy == STRATEGY_AGE ? SELECT_AGE : SELECT_WEIGHT;
+            opts.setOfSupport = r.strategy == STRATEGY_SOS;
+            opts.restriction = r.strategy == STRATEGY_ORDERED ? RESOLVE_ORDERED
+                             : r.strategy == STRATEGY_HYPER ? RESOLVE_HYPER
+                             : r.strategy == STRATEGY_LINEAR ? RESOLVE_LINEAR : RESOLVE_FULL;
+            opts.threads = 1;
+            r.proof->steps = proof.steps; // the copied disjuncts keep their steps
+            bool proven = MethodResolution(r.matr, opts, *r.proof, guard);
+            if (proven)
+                r.verdict = 1;
+            else if (guard.stopped == STOP_NONE && r.strategy != STRATEGY_SOS && r.strategy != STRATEGY_LINEAR)
+                r.verdict = 0;
+        }
+        r.stopped = guard.stopped;
+        r.seconds = guard.seconds();
+        int none = -1;
+        if (r.verdict >= 0 && winner.compare_exchange_strong(none, (int) k))
+            cancel = true;
+        finished++;
+    };
+    std::vector<std::thread> threads;
+    for (size_t k = 0; k < runs.size(); k++)
+        threads.push_back(std::thread(run, k));
+    while (finished < runs.size()) { // the cancellation by the user is passed on
+        if (options.budget.cancel && *options.budget.cancel)
+            cancel = true;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
     }
-    return false;
+    for (size_t k = 0; k < threads.size(); k++)
+        threads[k].join();
+    return winner;
 }
 
-// Write to the matrix of disjunctions 
-void WriteArr(int** matr, int* n, unsigned countVars, int* a) { 
-    for (int i = 0; i < countVars; i++) {
-        matr[*n][i] = a[i];
-    } 
-    (*n)++;
+ProofSession::ProofSession(const std::vector<String>& premises, const ProverOptions& options)
+    : options(options), matr(0), inconsistent(false) {
+    std::vector<std::vector<int> > clauses;
+    for (size_t i = 0; i < premises.size(); i++) {
+        convert('(' + premises[i] + ')', premiseLetters, clauses);
+        for (size_t k = 0; k < clauses.size(); k++) {
+            int n = WriteClause(matr, clauses[k]);
+            if (n >= 0)
+                matr.origins[n] = (int) i;
+        }
+    }
+    if (options.engine == ENGINE_CDCL) {
+        solver.reset(new Solver(matr));
+        return;
+    }
+    RecordInputs(matr, proof);
+    isProcessed.assign(matr.size(), 0);
+    for (int i = 0; i < matr.size(); i++)
+        if (matr.alive[i])
+            PushUnprocessed(unprocessed, matr, options, i);
 }
 
-// Output the disjunction 
-void PrintfArr(int** matr, int n, unsigned countVars, Set vars) { 
-    std::set<int>::iterator it;
-    std::cout << "(";
-    for (int i = 0, it = *vars.begin(); i < countVars; i++, it++) 
-        if (matr[n][i] != 1) {
-            if (matr[n][i] == -1)
-                std::cout << '-' << (Token)(it);
-            else
-                std::cout << (Token)(it);
-            std::cout << " | ";
+unsigned ProofSession::addVariables(unsigned count) {
+    unsigned first = matr.countVars;
+    AddVariables(matr, count);
+    if (solver)
+        solver->addVariables(count);
+    return first;
+}
+
+// The formula is converted over its own variables, which are then given
+// the numbers of the session; its letters are added to letters.
+// The auxiliary variables come after the letters
+unsigned ProofSession::convert(const String& formula, Set& letters, std::vector<std::vector<int> >& clauses) {
+    Queue expr = infixToPostfix(stringToSequence(formula));
+    Set vars;
+    unsigned countVars = getVariables(expr, vars);
+    unsigned auxVars = options.cnf == CNF_TSEITIN ? TseitinVars(expr) : 0;
+    ClauseSet part(countVars + auxVars);
+    unsigned nextVar = countVars;
+    if (options.cnf == CNF_TSEITIN)
+        Tseitin(expr, part, vars, nextVar);
+    else
+        SKNF(expr, part, vars, countVars);
+
+    std::vector<unsigned> numbers;
+    for (Set::const_iterator k = vars.begin(); k != vars.end(); k++) {
+        letters.insert(*k);
+        std::map<Token, unsigned>::iterator it = index.find(*k);
+        if (it == index.end()) {
+            it = index.insert(std::make_pair(*k, addVariables(1))).first;
+            matr.names[it->second] = String(1, *k);
         }
-    std::cout << "\b\b\b)";
+        numbers.push_back(it->second);
+    }
+    unsigned first = matr.countVars;
+    if (nextVar > countVars) {
+        addVariables(nextVar - countVars);
+        for (unsigned v = first; v < matr.countVars; v++) {
+            numbers.push_back(v);
+            matr.names[v] = "t" + std::to_string(v + 1);
+        }
+    }
+    clauses.clear();
+    std::vector<int> lits;
+    for (int i = 0; i < part.size(); i++) {
+        if (!part.alive[i])
+            continue;
+        ClauseLiterals(part.clause(i), lits);
+        for (size_t k = 0; k < lits.size(); k++)
+            lits[k] = literal(numbers[lits[k] / 2], lits[k] & 1);
+        clauses.push_back(lits);
+    }
+    return first;
+}
+
+void ProofSession::prepare(SearchGuard& guard) {
+    if (solver) {
+        inconsistent = !solver->solve(guard) && guard.stopped == STOP_NONE;
+        return;
+    }
+    if (options.threads > 1)
+        inconsistent = SaturateParallel(matr, options, proof, guard, unprocessed, isProcessed);
+    else
+        inconsistent = Saturate(matr, options, proof, guard, unprocessed, isProcessed);
+}
+
+// The auxiliary variables of the goal (and its selector) are dropped after it,
+// so the session does not grow with the goals; its letters are kept
+int ProofSession::check(const String& goal, SearchGuard& guard) {
+    std::vector<std::vector<int> > clauses;
+    goalLetters.clear();
+    values.clear();
+    unsigned first = convert("-(" + goal + ')', goalLetters, clauses);
+    if (inconsistent) {
+        RemoveVariables(matr, first);
+        if (solver)
+            solver->removeVariables(first);
+        return 1;
+    }
+
+    if (solver) {
+        // The disjuncts of the goal hold while the selector is true;
+        // they go away with it, and with the disjuncts learnt from them
+        int selector = literal(addVariables(1), false);
+        matr.names[selector / 2] = "s" + std::to_string(selector / 2 + 1);
+        for (size_t k = 0; k < clauses.size(); k++) {
+            clauses[k].push_back(complement(selector));
+            solver->addClause(clauses[k]);
+        }
+        bool satisfiable = solver->solve(guard, std::vector<int>(1, selector));
+        int verdict = guard.stopped != STOP_NONE ? -1 : satisfiable ? 0 : 1;
+        if (verdict == 0) {
+            values.resize(matr.countVars);
+            for (unsigned v = 0; v < matr.countVars; v++)
+                values[v] = solver->value(v);
+        }
+        solver->removeVariables(first);
+        RemoveVariables(matr, first);
+        return verdict;
+    }
+
+    // The changes of the goal are undone after it. The agenda of the premises
+    // is empty unless prepare was stopped; its entries are put back, and the
+    // disjuncts they name are unprocessed again
+    Agenda pending = unprocessed;
+    size_t savedSteps = proof.steps.size();
+    matr.keepChanges = true;
+    std::vector<int> added;
+    for (size_t k = 0; k < clauses.size(); k++) {
+        int n = WriteClause(matr, clauses[k]);
+        if (n >= 0) {
+            matr.origins[n] = ORIGIN_GOAL;
+            added.push_back(n);
+        }
+    }
+    RecordInputs(matr, proof);
+    isProcessed.resize(matr.size(), 0);
+    for (size_t k = 0; k < added.size(); k++) {
+        isProcessed[added[k]] = 0; // the slot may have been used before
+        PushUnprocessed(unprocessed, matr, options, added[k]);
+    }
+    bool proven = options.threads > 1
+        ? SaturateParallel(matr, options, proof, guard, unprocessed, isProcessed)
+        : Saturate(matr, options, proof, guard, unprocessed, isProcessed);
+    // A premise deleted by the goal was processed unless it is pending
+    std::vector<int> restored;
+    for (size_t k = 0; k < matr.changes.size(); k++)
+        if (matr.changes[k].deletion)
+            restored.push_back(matr.changes[k].n);
+    UndoChanges(matr);
+    RemoveVariables(matr, first);
+    for (size_t k = 0; k < restored.size(); k++)
+        if (matr.alive[restored[k]])
+            isProcessed[restored[k]] = 1;
+    unprocessed = Agenda();
+    for (; !pending.empty(); pending.pop()) {
+        int n = std::get<2>(pending.top());
+        if (matr.alive[n] && matr.ages[n] == std::get<1>(pending.top()))
+            isProcessed[n] = 0;
+        unprocessed.push(pending.top());
+    }
+    proof.steps.resize(savedSteps);
+    proof.empty = -1;
+    return proven ? 1 : guard.stopped != STOP_NONE ? -1 : 0;
+}
+
+std::vector<std::pair<Token, int> > ProofSession::counterexample() const {
+    std::vector<std::pair<Token, int> > res;
+    if (values.empty())
+        return res;
+    for (std::map<Token, unsigned>::const_iterator it = index.begin(); it != index.end(); it++)
+        if (premiseLetters.count(it->first) || goalLetters.count(it->first))
+            res.push_back(std::make_pair(it->first, values[it->second]));
+    return res;
+}
+
+int ProofSession::count() const {
+    return matr.count();
+}
+
+size_t ProofSession::memory() const {
+    return MemoryUsage(matr) + (solver ? solver->memory() : 0);
+}
+
+void PrintfCounterexample(const ClauseSet& matr, const Reconstruction& rec,
+                          std::vector<int> values, unsigned countVars) {
+    ExtendModel(rec, values);
+    std::cout << "Counterexample:";
+    for (unsigned j = 0; j < countVars; j++)
+        std::cout << (j ? ", " : " ") << matr.names[j] << " = " << values[j];
+    std::cout << "\n";
+}
+
+// Output the unifications the empty disjunct was derived by:
+// only the steps it depends on, in the order they were made
+std::vector<char> NeededSteps(const Derivation& proof) {
+    std::vector<char> needed(proof.steps.size(), 0);
+    if (proof.empty < 0)
+        return needed;
+    needed[proof.empty] = 1;
+    // The parents of a step always precede it
+    for (int k = proof.empty; k >= 0; k--) {
+        if (needed[k] && proof.steps[k].left >= 0) {
+            needed[proof.steps[k].left] = 1;
+            needed[proof.steps[k].right] = 1;
+        }
+    }
+    return needed;
+}
+
+void PrintfProof(const Derivation& proof, const ClauseSet& matr) {
+    if (proof.empty < 0)
+        return;
+    std::vector<char> needed = NeededSteps(proof);
+    for (int k = 0; k <= proof.empty; k++) {
+        const ProofStep& ps = proof.steps[k];
+        if (!needed[k] || ps.left < 0)
+            continue;
+        std::cout << "Performing unification ";
+        PrintfLits(proof.steps[ps.left].lits, matr.names);
+        std::cout << " and ";
+        PrintfLits(proof.steps[ps.right].lits, matr.names);
+        if (ps.lits.empty()) {
+            std::cout << ": empty resolvent\n";
+        } else {
+            std::cout << ": ";
+            PrintfLits(ps.lits, matr.names);
+            std::cout << " \n";
+        }
+    }
+}
+
+Core ProofCore(const Derivation& proof) {
+    Core core;
+    core.goal = false;
+    std::vector<char> needed = NeededSteps(proof);
+    std::set<int> premises;
+    for (size_t k = 0; k < needed.size(); k++) {
+        if (!needed[k] || proof.steps[k].left >= 0)
+            continue;
+        core.steps.push_back((int) k);
+        if (proof.steps[k].origin == ORIGIN_GOAL)
+            core.goal = true;
+        else
+            premises.insert(proof.steps[k].origin);
+    }
+    core.premises.assign(premises.begin(), premises.end());
+    return core;
+}
+
+// Are the disjuncts of the premises and of the negated consequence contradictory?
+// -1 if the guard stopped the search. The premises used by the proof are put into used
+static int refutes(const ClauseSet& input, const ProverOptions& options, const std::vector<int>& premises,
+                   SearchGuard& guard, std::vector<int>& used) {
+    ClauseSet matr(input.countVars);
+    matr.names = input.names;
+    for (int i = 0; i < input.size(); i++) {
+        if (!input.alive[i] || (input.origins[i] != ORIGIN_GOAL
+                                && !std::binary_search(premises.begin(), premises.end(), input.origins[i])))
+            continue;
+        int n = WriteArr(matr, input.clause(i));
+        matr.origins[n] = input.origins[i];
+    }
+    bool proven;
+    used = premises;
+    if (options.engine == ENGINE_CDCL) {
+        Solver solver(matr);
+        proven = !solver.solve(guard);
+    } else {
+        Derivation proof;
+        proven = MethodResolution(matr, options, proof, guard);
+        if (proven)
+            used = ProofCore(proof).premises;
+    }
+    return guard.stopped != STOP_NONE ? -1 : proven ? 1 : 0;
+}
+
+std::vector<int> MinimizeCore(const ClauseSet& matr, const ProverOptions& options,
+                              std::vector<int> premises, SearchGuard& guard, int& tries) {
+    tries = 0;
+    std::vector<int> rest, used;
+    // The premises are tried in order; the ones kept before the k-th are needed,
+    // and a smaller core keeps them, as their subsets are consistent
+    for (size_t k = 0; k < premises.size(); ) {
+        int p = premises[k];
+        rest = premises;
+        rest.erase(rest.begin() + k);
+        tries++;
+        int verdict = refutes(matr, options, rest, guard, used);
+        if (verdict < 0)
+            break;
+        if (verdict == 0) {
+            k++;
+        } else {
+            premises = used;
+            k = std::lower_bound(premises.begin(), premises.end(), p) - premises.begin();
+        }
+    }
+    return premises;
+}
+
+void PrintfCore(const Core& core, size_t inputs, bool dimacs) {
+    std::cout << "Core: " << core.steps.size() << " of " << inputs << " input disjuncts";
+    if (dimacs) { // the disjuncts are numbered in the order of the file
+        std::cout << ":";
+        for (size_t k = 0; k < core.steps.size(); k++)
+            std::cout << ' ' << core.steps[k] + 1;
+    } else {
+        std::cout << ", premises used:";
+        for (size_t k = 0; k < core.premises.size(); k++)
+            std::cout << (k ? ", " : " ") << core.premises[k] + 1;
+        if (core.premises.empty())
+            std::cout << " none";
+        if (!core.goal)
+            std::cout << "; the consequence is not used, the premises are contradictory";
+    }
+    std::cout << "\n";
+}
+
+// x-th element of the Luby sequence with base y: 1, 1, y, 1, 1, y, y^2, ...
+// (the lengths of the runs between restarts)
+double luby(double y, int x) {
+    int size = 1, seq = 0;
+    while (size < x + 1) {
+        seq++;
+        size = 2 * size + 1;
+    }
+    while (size - 1 != x) {
+        size = (size - 1) >> 1;
+        seq--;
+        x = x % size;
+    }
+    double r = 1;
+    for (int i = 0; i < seq; i++)
+        r *= y;
+    return r;
+}
+
+Solver::Solver(const ClauseSet& matr)
+    : conflicts(0), decisions(0), propagations(0), countVars(matr.countVars), contradiction(false),
+      watches(2 * matr.countVars), values(matr.countVars, -1), levels(matr.countVars, 0),
+      reasons(matr.countVars, -1), phases(matr.countVars, 0), seen(matr.countVars, 0), qhead(0),
+      activity(matr.countVars, 0), varInc(1), clauseInc(1), heapPos(matr.countVars, -1), learnts(0) {
+    for (unsigned v = 0; v < countVars; v++)
+        heapInsert(v);
+    std::vector<int> lits;
+    for (int i = 0; i < matr.size() && !contradiction; i++) {
+        if (!matr.alive[i] || Tautology(matr.clause(i)))
+            continue;
+        ClauseLiterals(matr.clause(i), lits);
+        if (lits.empty()) {
+            contradiction = true;
+        } else if (lits.size() == 1) { // a unit disjunct is a fact of level 0
+            if (litValue(lits[0]) == 0)
+                contradiction = true;
+            else if (litValue(lits[0]) < 0)
+                enqueue(lits[0], -1);
+        } else {
+            SolverClause c = { lits, false, false, 0, 0 };
+            clauses.push_back(c);
+            attach((int) clauses.size() - 1);
+        }
+    }
+    maxLearnts = clauses.size() / 3 + 1000;
+}
+
+// Value of the literal: -1 unassigned, 0 false, 1 true
+int Solver::litValue(int l) const {
+    signed char v = values[l >> 1];
+    return v < 0 ? -1 : v ^ (l & 1);
+}
+
+int Solver::decisionLevel() const {
+    return (int) trailLim.size();
+}
+
+int Solver::value(unsigned var) const {
+    return values[var] > 0 ? 1 : 0;
+}
+
+// Watch the first two literals of the c-th disjunct
+void Solver::attach(int c) {
+    watches[clauses[c].lits[0]].push_back(c);
+    watches[clauses[c].lits[1]].push_back(c);
+}
+
+// Make the literal true; reason is the disjunct implying it (-1 for a decision)
+void Solver::enqueue(int l, int reason) {
+    values[l >> 1] = (l & 1) ? 0 : 1;
+    levels[l >> 1] = decisionLevel();
+    reasons[l >> 1] = reason;
+    trail.push_back(l);
 }
 
-// Resolution method 
-bool MethodResolution(int** matr, int n, unsigned countVars, Set vars) { 
-    int k = n, tk = n;
-    int* a = new int[countVars];
-    const time_t TIMEOUT_LIMIT = 100; // Time limit allocated for finding a solution 
-    time_t start = time(NULL); // Start time for finding a solution 
-    bool is_solved = false;
-
-    while (time(NULL) - start < TIMEOUT_LIMIT && !is_solved) { 
-        for (int i = 0; i < k - 1 && !is_solved; i++)
-            for (int j = i + 1; j < k && !is_solved; j++) { 
-                for (int z = 0; z < countVars; z++) {
-                    if (matr[i][z] == 0 && matr[j][z] == -1 || matr[i][z] == -1 && matr[j][z] == 0) 
-                        a[z] = 1;
-                    else if (matr[i][z] == 0 || matr[j][z] == 0) 
-                        a[z] = 0;
-                    else if (matr[i][z] == -1 && matr[j][z] == -1) 
-                        a[z] = -1;
-                    else if (matr[i][z] == 1 && matr[j][z] == 1) 
-                        a[z] = 1;
+// Unit propagation: for every disjunct watching a false literal
+// find another watch, or imply its other watched literal.
+// Return the number of a falsified disjunct or -1
+int Solver::propagate() {
+    while (qhead < trail.size()) {
+        int f = complement(trail[qhead++]); // this literal has just become false
+        propagations++;
+        std::vector<int>& ws = watches[f];
+        size_t i = 0, j = 0;
+        while (i < ws.size()) {
+            int ci = ws[i++];
+            SolverClause& c = clauses[ci];
+            if (c.deleted)
+                continue; // drop the watch of a deleted disjunct
+            if (c.lits[0] == f)
+                std::swap(c.lits[0], c.lits[1]);
+            if (litValue(c.lits[0]) == 1) { // the disjunct is already true
+                ws[j++] = ci;
+                continue;
+            }
+            bool moved = false;
+            for (size_t k = 2; k < c.lits.size(); k++) {
+                if (litValue(c.lits[k]) != 0) {
+                    std::swap(c.lits[1], c.lits[k]);
+                    watches[c.lits[1]].push_back(ci);
+                    moved = true;
+                    break;
                 }
-                is_solved = EmptySequence(a, countVars); 
-                if (is_solved) {
-                    std::cout << "Performing unification "; 
-                    PrintfArr(matr, i, countVars, vars); 
-                    std::cout << " and ";
-                    PrintfArr(matr, j, countVars, vars); 
-                    std::cout << ": empty resolvent\n"; 
-                    return true;
-                } else {
-                    if (!SearchArr(matr, tk, countVars, a)) { 
-                        WriteArr(matr, &tk, countVars, a); 
-                        std::cout << "Performing unification "; 
-                        PrintfArr(matr, i, countVars, vars); 
-                        std::cout << " and ";
-                        PrintfArr(matr, j, countVars, vars); 
-                        std::cout << ": ";
-                        PrintfArr(matr, tk, countVars, vars); 
-                        std::cout << " \n";
-                    }
+            }
+            if (moved)
+                continue;
+            ws[j++] = ci;
+            if (litValue(c.lits[0]) == 0) { // all literals are false
+                while (i < ws.size())
+                    ws[j++] = ws[i++];
+                ws.resize(j);
+                return ci;
+            }
+            enqueue(c.lits[0], ci);
+        }
+        ws.resize(j);
+    }
+    return -1;
+}
+
+// Find the first-UIP disjunct learnt from the conflict,
+// the level to return to and the number of decision levels in the disjunct
+void Solver::analyze(int confl, std::vector<int>& learnt, int& backLevel, unsigned& lbd) {
+    learnt.assign(1, 0);
+    int pathC = 0;
+    int p = -1;
+    int idx = (int) trail.size() - 1;
+    do {
+        SolverClause& c = clauses[confl];
+        if (c.learnt)
+            bumpClause(confl);
+        // The implied literal of a reason is its first one
+        for (size_t k = (p < 0 ? 0 : 1); k < c.lits.size(); k++) {
+            int q = c.lits[k];
+            int v = q >> 1;
+            if (!seen[v] && levels[v] > 0) {
+                seen[v] = 1;
+                bumpVar(v);
+                if (levels[v] >= decisionLevel())
+                    pathC++;
+                else
+                    learnt.push_back(q);
+            }
+        }
+        while (!seen[trail[idx] >> 1])
+            idx--;
+        p = trail[idx--];
+        confl = reasons[p >> 1];
+        seen[p >> 1] = 0;
+        pathC--;
+    } while (pathC > 0);
+    learnt[0] = complement(p);
+
+    backLevel = 0;
+    for (size_t k = 1; k < learnt.size(); k++) {
+        seen[learnt[k] >> 1] = 0;
+        if (levels[learnt[k] >> 1] > backLevel) {
+            backLevel = levels[learnt[k] >> 1];
+            std::swap(learnt[1], learnt[k]); // the second watch is on the deepest level
+        }
+    }
+    std::set<int> distinct;
+    for (size_t k = 0; k < learnt.size(); k++)
+        distinct.insert(levels[learnt[k] >> 1]);
+    lbd = (unsigned) distinct.size();
+}
+
+// Undo the assignments above the decision level
+void Solver::backtrack(int level) {
+    if (decisionLevel() <= level)
+        return;
+    for (int k = (int) trail.size() - 1; k >= trailLim[level]; k--) {
+        int v = trail[k] >> 1;
+        phases[v] = values[v];
+        values[v] = -1;
+        reasons[v] = -1;
+        if (heapPos[v] < 0)
+            heapInsert(v);
+    }
+    trail.resize(trailLim[level]);
+    trailLim.resize(level);
+    qhead = trail.size();
+}
+
+// Raise the activity of a variable met in a conflict
+void Solver::bumpVar(int v) {
+    if ((activity[v] += varInc) > 1e100) { // rescale all activities
+        for (unsigned k = 0; k < countVars; k++)
+            activity[k] *= 1e-100;
+        varInc *= 1e-100;
+    }
+    if (heapPos[v] >= 0)
+        heapUp(heapPos[v]);
+}
+
+// Raise the activity of a learnt disjunct met in a conflict
+void Solver::bumpClause(int c) {
+    if ((clauses[c].activity += clauseInc) > 1e20) {
+        for (size_t k = 0; k < clauses.size(); k++)
+            clauses[k].activity *= 1e-20;
+        clauseInc *= 1e-20;
+    }
+}
+
+void Solver::heapUp(int i) {
+    int v = heap[i];
+    while (i > 0 && activity[heap[(i - 1) / 2]] < activity[v]) {
+        heap[i] = heap[(i - 1) / 2];
+        heapPos[heap[i]] = i;
+        i = (i - 1) / 2;
+    }
+    heap[i] = v;
+    heapPos[v] = i;
+}
+
+void Solver::heapDown(int i) {
+    int v = heap[i];
+    int n = (int) heap.size();
+    while (2 * i + 1 < n) {
+        int child = 2 * i + 1;
+        if (child + 1 < n && activity[heap[child + 1]] > activity[heap[child]])
+            child++;
+        if (activity[heap[child]] <= activity[v])
+            break;
+        heap[i] = heap[child];
+        heapPos[heap[i]] = i;
+        i = child;
+    }
+    heap[i] = v;
+    heapPos[v] = i;
+}
+
+void Solver::heapInsert(int v) {
+    heap.push_back(v);
+    heapPos[v] = (int) heap.size() - 1;
+    heapUp(heapPos[v]);
+}
+
+void Solver::heapRemove(int v) {
+    int i = heapPos[v];
+    int last = heap.back();
+    heap.pop_back();
+    heapPos[v] = -1;
+    if (last == v)
+        return;
+    heap[i] = last;
+    heapPos[last] = i;
+    heapUp(i);
+    heapDown(heapPos[last]);
+}
+
+int Solver::heapPop() {
+    int v = heap[0];
+    heap[0] = heap.back();
+    heapPos[heap[0]] = 0;
+    heap.pop_back();
+    heapPos[v] = -1;
+    if (!heap.empty())
+        heapDown(0);
+    return v;
+}
+
+// The most active unassigned variable with its saved phase, -1 if all are assigned
+int Solver::pickBranchLit() {
+    while (!heap.empty()) {
+        int v = heapPop();
+        if (values[v] < 0)
+            return literal(v, phases[v] == 0);
+    }
+    return -1;
+}
+
+// Delete half of the learnt disjuncts: those with more decision levels
+// and lower activity first; disjuncts with two levels and reasons are kept
+void Solver::reduceLearnts() {
+    std::vector<int> cand;
+    for (size_t k = 0; k < clauses.size(); k++) {
+        SolverClause& c = clauses[k];
+        if (!c.learnt || c.deleted || c.lbd <= 2)
+            continue;
+        if (reasons[c.lits[0] >> 1] == (int) k && litValue(c.lits[0]) == 1)
+            continue;
+        cand.push_back((int) k);
+    }
+    std::sort(cand.begin(), cand.end(), [this](int a, int b) {
+        if (clauses[a].lbd != clauses[b].lbd)
+            return clauses[a].lbd > clauses[b].lbd;
+        return clauses[a].activity < clauses[b].activity;
+    });
+    for (size_t k = 0; k < cand.size() / 2; k++) {
+        clauses[cand[k]].deleted = true;
+        std::vector<int>().swap(clauses[cand[k]].lits);
+        learnts--;
+    }
+}
+
+// Store a learnt disjunct of two or more literals and imply its first literal
+int Solver::addLearnt(const std::vector<int>& lits, unsigned lbd) {
+    SolverClause c = { lits, true, false, lbd, 0 };
+    clauses.push_back(c);
+    int ci = (int) clauses.size() - 1;
+    attach(ci);
+    bumpClause(ci);
+    learnts++;
+    enqueue(lits[0], ci);
+    return ci;
+}
+
+bool Solver::solve(SearchGuard& guard, const std::vector<int>& assumptions) {
+    backtrack(0);
+    if (!contradiction && propagate() >= 0)
+        contradiction = true;
+    if (contradiction)
+        return false;
+    std::vector<int> learnt;
+    std::function<size_t()> mem = [this]() { return memory(); };
+    unsigned long long first = conflicts; // the steps of this search
+    for (int restart = 0; ; restart++) {
+        double budget = luby(2, restart) * 100; // conflicts before the next restart
+        for (int c = 0; c < budget; ) {
+            if (guard.stop(clauses.size(), conflicts - first, mem))
+                return false;
+            int confl = propagate();
+            if (confl >= 0) {
+                conflicts++;
+                c++;
+                if (decisionLevel() == 0) {
+                    contradiction = true;
+                    return false;
+                }
+                int backLevel;
+                unsigned lbd;
+                analyze(confl, learnt, backLevel, lbd);
+                backtrack(backLevel);
+                if (learnt.size() == 1)
+                    enqueue(learnt[0], -1);
+                else
+                    addLearnt(learnt, lbd);
+                varInc /= 0.95;
+                clauseInc /= 0.999;
+            } else {
+                if (learnts >= maxLearnts + trail.size()) {
+                    reduceLearnts();
+                    maxLearnts = maxLearnts * 11 / 10;
+                }
+                // The assumptions are decided first, one level each
+                int l = -1;
+                while (l < 0 && decisionLevel() < (int) assumptions.size()) {
+                    int p = assumptions[decisionLevel()];
+                    if (litValue(p) == 0)
+                        return false; // the disjuncts imply its negation
+                    if (litValue(p) > 0)
+                        trailLim.push_back((int) trail.size()); // a level with nothing decided
+                    else
+                        l = p;
                 }
+                if (l < 0) {
+                    l = pickBranchLit();
+                    if (l < 0)
+                        return true; // every variable has a value, no disjunct is false
+                    decisions++;
+                }
+                trailLim.push_back((int) trail.size());
+                enqueue(l, -1);
             }
-        k = tk;
+        }
+        backtrack(0);
+    }
+}
+
+void Solver::addVariables(unsigned count) {
+    unsigned from = countVars;
+    countVars += count;
+    watches.resize(2 * countVars);
+    values.resize(countVars, -1);
+    levels.resize(countVars, 0);
+    reasons.resize(countVars, -1);
+    phases.resize(countVars, 0);
+    seen.resize(countVars, 0);
+    activity.resize(countVars, 0);
+    heapPos.resize(countVars, -1);
+    for (unsigned v = from; v < countVars; v++)
+        heapInsert(v);
+}
+
+// The disjuncts left are renumbered and watched again on the same literals.
+// A disjunct with the dropped variables never implies a fact of level 0
+// (they only occur with a selector that is assumed at level 1 or false),
+// so the facts left keep their meaning; their reasons are renumbered too
+void Solver::removeVariables(unsigned first) {
+    backtrack(0);
+    std::vector<int> number(clauses.size(), -1);
+    size_t k = 0;
+    for (size_t c = 0; c < clauses.size(); c++) {
+        SolverClause& cl = clauses[c];
+        bool drop = cl.deleted;
+        for (size_t j = 0; j < cl.lits.size() && !drop; j++)
+            drop = (unsigned) (cl.lits[j] >> 1) >= first;
+        if (drop) {
+            if (cl.learnt && !cl.deleted)
+                learnts--;
+            continue;
+        }
+        number[c] = (int) k;
+        if (k != c)
+            clauses[k] = std::move(cl);
+        k++;
+    }
+    clauses.resize(k);
+    for (size_t l = 0; l < 2 * (size_t) first; l++)
+        watches[l].clear();
+    watches.resize(2 * first);
+    for (size_t c = 0; c < clauses.size(); c++)
+        attach((int) c);
+
+    size_t kept = 0, head = 0;
+    for (size_t t = 0; t < trail.size(); t++) {
+        unsigned v = trail[t] >> 1;
+        if (t == qhead)
+            head = kept;
+        if (v >= first)
+            continue;
+        if (reasons[v] >= 0)
+            reasons[v] = number[reasons[v]];
+        trail[kept++] = trail[t];
+    }
+    qhead = qhead >= trail.size() ? kept : head;
+    trail.resize(kept);
+    for (unsigned v = first; v < countVars; v++)
+        if (heapPos[v] >= 0)
+            heapRemove(v);
+    countVars = first;
+    values.resize(first);
+    levels.resize(first);
+    reasons.resize(first);
+    phases.resize(first);
+    seen.resize(first);
+    activity.resize(first);
+    heapPos.resize(first);
+}
+
+// The facts of level 0 are taken into account: false literals are dropped,
+// a disjunct with a true one is not kept
+void Solver::addClause(std::vector<int> lits) {
+    backtrack(0);
+    if (contradiction)
+        return;
+    size_t k = 0;
+    for (size_t i = 0; i < lits.size(); i++) {
+        int value = litValue(lits[i]);
+        if (value > 0 || std::find(lits.begin(), lits.begin() + k, complement(lits[i])) != lits.begin() + k)
+            return;
+        if (value < 0 && std::find(lits.begin(), lits.begin() + k, lits[i]) == lits.begin() + k)
+            lits[k++] = lits[i];
+    }
+    lits.resize(k);
+    if (lits.empty()) {
+        contradiction = true;
+    } else if (lits.size() == 1) {
+        enqueue(lits[0], -1);
+    } else {
+        SolverClause c = { lits, false, false, 0, 0 };
+        clauses.push_back(c);
+        attach((int) clauses.size() - 1);
+    }
+}
+
+// Bytes taken by the disjuncts of the solver and the watches
+size_t Solver::memory() const {
+    size_t bytes = clauses.capacity() * sizeof(SolverClause);
+    for (size_t c = 0; c < clauses.size(); c++)
+        bytes += clauses[c].lits.capacity() * sizeof(int);
+    for (size_t l = 0; l < watches.size(); l++)
+        bytes += watches[l].capacity() * sizeof(int);
+    return bytes;
+}
+
+SearchGuard::SearchGuard(const Budget& budget)
+    : stopped(STOP_NONE), budget(budget), start(std::chrono::steady_clock::now()),
+      nextReport(budget.progressInterval), calls(0) {}
+
+double SearchGuard::seconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool SearchGuard::stop(size_t clauses, unsigned long long steps, const std::function<size_t()>& memory) {
+    if (stopped != STOP_NONE)
+        return true;
+    if (budget.cancel && budget.cancel->load(std::memory_order_relaxed))
+        stopped = STOP_CANCELLED;
+    else if (budget.maxClauses && clauses > budget.maxClauses)
+        stopped = STOP_CLAUSES;
+    else if (budget.maxSteps && steps >= budget.maxSteps)
+        stopped = STOP_STEPS;
+    if (stopped != STOP_NONE || ++calls % GUARD_PERIOD != 0)
+        return stopped != STOP_NONE;
+
+    double now = seconds();
+    size_t bytes = budget.maxMemory || budget.progress ? memory() : 0;
+    if (budget.timeLimit > 0 && now >= budget.timeLimit)
+        stopped = STOP_TIME;
+    else if (budget.maxMemory && bytes > budget.maxMemory)
+        stopped = STOP_MEMORY;
+    if (budget.progress && now >= nextReport) {
+        Progress p = { clauses, bytes, steps, now, now > 0 ? steps / now : 0 };
+        budget.progress(p);
+        nextReport = now + budget.progressInterval;
+    }
+    return stopped != STOP_NONE;
+}
+
+const char* StopReason(Stop stop) {
+    switch (stop) {
+        case STOP_CLAUSES: return "the limit of disjuncts is reached";
+        case STOP_MEMORY: return "the memory limit is reached";
+        case STOP_STEPS: return "the limit of steps is reached";
+        case STOP_TIME: return "the time limit is reached";
+        case STOP_CANCELLED: return "the search was cancelled";
+        default: return "the search is finished";
     }
-    return is_solved;
 }
 
 // Output the set of disjuncts
-void PrintfSetDis(int** matr, int n, int countVars, Set vars) {
+void PrintfSetDis(const ClauseSet& matr) {
     std::cout << "{";
-    for (int i = 0; i < n; i++) {
-        PrintfArr(matr, i, countVars, vars);
+    for (int i = 0; i < matr.size(); i++) {
+        if (!matr.alive[i])
+            continue;
+        PrintfArr(matr, i);
         std::cout << ", ";
     }
     std::cout << "\b\b}"; // Remove the last comma and space
 }
 
-// Main program
-int main() {
-    try {
-        std::cout << "Enter the number of premises: ";
-        int n;
-        String expres;
-        std::cin >> n;
-        getchar(); // Clear input
-        expres += "-(";
-
-        // Input formulas
-        String exp;
-        for (int i = 0; i < n - 1; i++) {
-            exp = inputExpr();
-            expres += '(' + exp + ")&";
-        }
-        exp = inputExpr();
-        expres += '(' + exp + ')'; 
-        expres += ")>";
-
-        std::cout << "Enter the consequence to check\n"; 
-        exp = inputExpr();
-        expres = expres + '(' + exp + ")"; 
-        expres += ")";
-
-        // Convert expression to a sequence of tokens
-        Queue input = stringToSequence(expres);
-        
-        // Convert the sequence of tokens to postfix notation (RPN)
-        Queue output = infixToPostfix(input);
+// Read the settings of the prover from the command line:
+// --cnf=table|tseitin  conversion of the formulas to disjuncts
+// --engine=resolution|cdcl  algorithm deciding the set of disjuncts
+// --select=weight|age  order of selecting the given disjuncts
+// --resolution=full|ordered|linear|hyper  pairs of disjuncts resolved
+// --order=A,B,...      variables of ordered resolution from the greatest
+// --proof=FILE         write the resolution proof to the file
+// --proof-format=drat|lrat  format of the proof file
+// --preprocess         simplify the disjuncts before the proof
+// --eliminate          eliminate variables by resolution before the proof
+// --sos                set-of-support strategy
+// --max-clauses=N      stop the search with more than N disjuncts in use
+// --max-memory=KIB     stop the search when the disjuncts take more memory
+// --max-steps=N        stop the search after N resolutions (conflicts for CDCL)
+// --timeout=SECONDS    stop the search after the time (100 by default, 0 for none)
+// --progress[=SECONDS] report the progress of the search to stderr
+// --threads=N          resolve on N threads
+// --portfolio          race several strategies on separate threads
+// --dimacs=FILE        read the disjuncts from a DIMACS CNF file instead of the formulas
+// --write-dimacs=FILE  write the disjuncts to a DIMACS CNF file before the search
+// --session            check many consequences of the same premises, one per line
+// --core               report the premises used by the proof
+// --minimize-core      and minimize them by further proofs
+// Non-negative number after the first pos characters of the option
+static double optionNumber(const String& arg, size_t pos) {
+    char* end;
+    double value = std::strtod(arg.c_str() + pos, &end);
+    if (end == arg.c_str() + pos || *end || value < 0)
+        throw String("Wrong value of the option ") + arg;
+    return value;
+}
+
+ProverOptions parseOptions(int argc, char* argv[]) {
+    ProverOptions options;
+    for (int i = 1; i < argc; i++) {
+        String arg = argv[i];
+        if (arg == "--cnf=table") {
+            options.cnf = CNF_TABLE;
+        } else if (arg == "--cnf=tseitin") {
+            options.cnf = CNF_TSEITIN;
+        } else if (arg == "--engine=resolution") {
+            options.engine = ENGINE_RESOLUTION;
+        } else if (arg == "--engine=cdcl") {
+            options.engine = ENGINE_CDCL;
+        } else if (arg == "--select=weight") {
+            options.selection = SELECT_WEIGHT;
+        } else if (arg == "--select=age") {
+            options.selection = SELECT_AGE;
+        } else if (arg == "--resolution=full") {
+            options.restriction = RESOLVE_FULL;
+        } else if (arg == "--resolution=ordered") {
+            options.restriction = RESOLVE_ORDERED;
+        } else if (arg == "--resolution=linear") {
+            options.restriction = RESOLVE_LINEAR;
+        } else if (arg == "--resolution=hyper") {
+            options.restriction = RESOLVE_HYPER;
+        } else if (arg.compare(0, 8, "--order=") == 0) {
+            options.order = arg.substr(8);
+        } else if (arg.compare(0, 9, "--dimacs=") == 0) {
+            options.dimacsFile = arg.substr(9);
+        } else if (arg.compare(0, 15, "--write-dimacs=") == 0) {
+            options.exportFile = arg.substr(15);
+        } else if (arg.compare(0, 8, "--proof=") == 0) {
+            options.proofFile = arg.substr(8);
+        } else if (arg == "--proof-format=drat") {
+            options.lrat = false;
+        } else if (arg == "--proof-format=lrat") {
+            options.lrat = true;
+        } else if (arg == "--preprocess") {
+            options.preprocess = true;
+        } else if (arg == "--eliminate") {
+            options.eliminate = true;
+        } else if (arg == "--sos") {
+            options.setOfSupport = true;
+        } else if (arg.compare(0, 14, "--max-clauses=") == 0) {
+            options.budget.maxClauses = (size_t) optionNumber(arg, 14);
+        } else if (arg.compare(0, 13, "--max-memory=") == 0) {
+            options.budget.maxMemory = (size_t) optionNumber(arg, 13) * 1024;
+        } else if (arg.compare(0, 12, "--max-steps=") == 0) {
+            options.budget.maxSteps = (unsigned long long) optionNumber(arg, 12);
+        } else if (arg.compare(0, 10, "--timeout=") == 0) {
+            options.budget.timeLimit = optionNumber(arg, 10);
+        } else if (arg == "--portfolio") {
+            options.portfolio = true;
+        } else if (arg == "--session") {
+            options.session = true;
+        } else if (arg == "--core") {
+            options.core = true;
+        } else if (arg == "--minimize-core") {
+            options.core = options.minimizeCore = true;
+        } else if (arg.compare(0, 10, "--threads=") == 0) {
+            options.threads = (unsigned) optionNumber(arg, 10);
+            if (options.threads == 0)
+                throw String("Wrong value of the option ") + arg;
+        } else if (arg == "--progress" || arg.compare(0, 11, "--progress=") == 0) {
+            if (arg.size() > 10)
+                options.budget.progressInterval = optionNumber(arg, 11);
+            options.budget.progress = [](const Progress& p) {
+                std::cerr << "Progress: " << p.seconds << " s, disjuncts: " << p.clauses
+                          << ", memory: " << (p.memory + 1023) / 1024 << " KiB, steps: " << p.steps
+                          << " (" << (unsigned long long) p.rate << " per second)\n";
+            };
+        } else {
+            throw String("Unknown option ") + arg;
+        }
+    }
+    if (options.restriction != RESOLVE_FULL && (options.setOfSupport || options.threads > 1))
+        throw String("The set of support and threads work with full resolution only");
+    if (options.portfolio && !options.proofFile.empty())
+        throw String("The proof file is not written by the portfolio");
+    if (options.session && (options.portfolio || options.setOfSupport || !options.proofFile.empty()
+                            || !options.dimacsFile.empty() || options.preprocess || options.eliminate))
+        throw String("A session takes no portfolio, set of support, proof file, DIMACS file or simplification");
+    if (options.session && (options.restriction == RESOLVE_LINEAR || options.restriction == RESOLVE_HYPER))
+        throw String("A session works with full or ordered resolution");
+    if (options.core && (options.session || (options.minimizeCore && !options.dimacsFile.empty())))
+        throw String("The core is found for the premises of one consequence");
+    if (options.core && options.engine == ENGINE_CDCL)
+        options.minimizeCore = true;
+    return options;
+}
+
+// Read the premises and the consequence and build the set of their disjuncts;
+// countVars is set to the number of variables of the formulas
+static ClauseSet inputFormulas(const ProverOptions& options, unsigned& countVars) {
+    std::cout << "Enter the number of premises: ";
+    int n;
+    std::cin >> n;
+    getchar(); // Clear input
+
+    // Input formulas: the premises and the negated consequence,
+    // the theorem is proven if their conjunction is contradictory
+    std::vector<String> formulas;
+    for (int i = 0; i < n; i++)
+        formulas.push_back('(' + inputExpr() + ')');
+
+    std::cout << "Enter the consequence to check\n"; 
+    formulas.push_back("-(" + inputExpr() + ')');
+
+    // Convert the formulas to sequences of tokens in postfix notation (RPN)
+    // and collect the variables of all of them
+    std::vector<Queue> outputs;
+    Set vars;
+    countVars = 0;
+    for (size_t i = 0; i < formulas.size(); i++) {
+        outputs.push_back(infixToPostfix(stringToSequence(formulas[i])));
+        countVars += getVariables(outputs.back(), vars);
+    }
+
+    // Build the set of CNF disjuncts: the disjuncts of the premises,
+    // then the disjuncts of the negated consequence
+    unsigned auxVars = 0;
+    if (options.cnf == CNF_TSEITIN)
+        for (size_t i = 0; i < outputs.size(); i++)
+            auxVars += TseitinVars(outputs[i]);
+    ClauseSet matr(countVars + auxVars);
+    Set::const_iterator k = vars.begin();
+    for (unsigned j = 0; j < countVars; j++, k++)
+        matr.names[j] = String(1, *k);
+    unsigned nextVar = countVars;
+    for (int i = 0; i <= n; i++) {
+        // For the core a disjunct of several formulas is kept for each of them,
+        // so a premise is never needed for the disjuncts of another one
+        ClauseSet part(options.core ? matr.countVars : 0);
+        ClauseSet& into = options.core ? part : matr;
+        into.names = matr.names;
+        int from = into.size();
+        if (options.cnf == CNF_TSEITIN) {
+            Tseitin(outputs[i], into, vars, nextVar);
+        } else {
+            // The table is built over the variables of the formula only,
+            // then they are given their numbers among all the variables
+            Set own;
+            unsigned ownVars = getVariables(outputs[i], own);
+            ClauseSet table(ownVars);
+            SKNF(outputs[i], table, own, ownVars);
+            std::vector<unsigned> numbers;
+            for (Set::const_iterator v = own.begin(); v != own.end(); v++)
+                numbers.push_back((unsigned) std::distance(vars.begin(), vars.find(*v)));
+            std::vector<int> lits;
+            for (int j = 0; j < table.size(); j++) {
+                if (!table.alive[j])
+                    continue;
+                ClauseLiterals(table.clause(j), lits);
+                for (size_t l = 0; l < lits.size(); l++)
+                    lits[l] = literal(numbers[lits[l] / 2], lits[l] & 1);
+                WriteClause(into, lits);
+            }
+        }
+        matr.names = into.names;
+        if (options.core) {
+            for (int j = 0; j < part.size(); j++)
+                WriteArr(matr, part.clause(j));
+            from = matr.size() - part.size();
+        }
+        for (int j = from; j < matr.size(); j++)
+            matr.origins[j] = i < n ? i : ORIGIN_GOAL;
+    }
+    return matr;
+}
 
-        Set vars;
-        unsigned countVars = getVariables(output, vars);
-        unsigned t = 1 << countVars;
+// Set by Ctrl+C to stop the search
+static std::atomic<bool> interrupted(false);
 
-        // Create matrix
-        int** matr = new int*[3 * t];
-        for (int i = 0; i < 3 * t; i++) {
-            matr[i] = new int[countVars];
+static void onInterrupt(int) {
+    interrupted = true;
+}
+
+// Read the premises once, then check the consequences entered one by one
+// until an empty line
+static void proveGoals(const ProverOptions& options) {
+    std::cout << "Enter the number of premises: ";
+    int n;
+    std::cin >> n;
+    getchar(); // Clear input
+    std::vector<String> premises;
+    for (int i = 0; i < n; i++)
+        premises.push_back(inputExpr());
+
+    std::signal(SIGINT, onInterrupt);
+    ProofSession session(premises, options);
+    {
+        SearchGuard guard(options.budget);
+        session.prepare(guard);
+        std::cout << "The premises are prepared in " << guard.seconds() << " s, disjuncts kept: "
+                  << session.count() << "\n";
+        if (guard.stopped != STOP_NONE)
+            std::cout << "The preparation was stopped: " << StopReason(guard.stopped)
+                      << "; the consequences are checked all the same\n";
+        else if (session.contradictory())
+            std::cout << "The premises are contradictory; every consequence follows\n";
+    }
+
+    int proven = 0, disproven = 0, undecided = 0;
+    for (int k = 1; ; k++) {
+        std::cout << "Enter the consequence to check (an empty line to finish)\n";
+        String goal = inputExpr();
+        if (!std::cin || goal.empty())
+            break;
+        SearchGuard guard(options.budget);
+        int verdict;
+        try {
+            verdict = session.check(goal, guard);
+        } catch (const String& err) {
+            printErrorMessage(err);
+            continue;
+        }
+        std::cout << "Consequence " << k << ": ";
+        if (verdict == 1) {
+            std::cout << "proven";
+            proven++;
+        } else if (verdict == 0) {
+            std::cout << "disproven";
+            disproven++;
+        } else {
+            std::cout << "stopped, " << StopReason(guard.stopped);
+            undecided++;
+        }
+        std::cout << " in " << guard.seconds() << " s\n";
+        std::vector<std::pair<Token, int> > values = session.counterexample();
+        if (!values.empty()) {
+            std::cout << "Counterexample:";
+            for (size_t j = 0; j < values.size(); j++)
+                std::cout << (j ? ", " : " ") << values[j].first << " = " << values[j].second;
+            std::cout << "\n";
+        }
+        if (guard.stopped == STOP_CANCELLED)
+            break;
+    }
+    std::signal(SIGINT, SIG_DFL);
+    std::cout << "Proven: " << proven << ", disproven: " << disproven << ", undecided: " << undecided
+              << "; disjuncts kept: " << session.count() << ", memory used: "
+              << (session.memory() + 1023) / 1024 << " KiB\n";
+}
+
+// Main program
+int main(int argc, char* argv[]) {
+    try {
+        ProverOptions options = parseOptions(argc, argv);
+        options.budget.cancel = &interrupted;
+        if (options.session) {
+            proveGoals(options);
+            return 0;
+        }
+        Derivation proof;
+        unsigned countVars;
+        ClauseSet matr(0);
+        if (options.dimacsFile.empty()) {
+            matr = inputFormulas(options, countVars);
+            std::cout << "Set of disjuncts:\n"; 
+            PrintfSetDis(matr); 
+            std::cout << "\n";
+        } else {
+            matr = ReadDimacs(options.dimacsFile, proof);
+            countVars = matr.countVars;
+            std::cout << "Read " << countVars << " variables and " << proof.steps.size()
+                      << " disjuncts from " << options.dimacsFile << ", disjuncts in use: "
+                      << matr.count() << "\n";
         }
 
-        // Build the CNF matrix
-        unsigned k = SKNF(output, matr, vars, countVars);
+        // With the set written out the proof refers to its disjuncts, so it is
+        // opened once they are written
+        auto openProof = [&]() {
+            proof.file.open(options.proofFile.c_str());
+            if (!proof.file)
+                throw String("Cannot open the proof file ") + options.proofFile;
+            proof.lrat = options.lrat;
+        };
+        if (!options.proofFile.empty() && options.exportFile.empty())
+            openProof();
+        RecordInputs(matr, proof);
+        size_t inputs = proof.steps.size();
+        // The premises and the input disjuncts are kept for the minimization of the core
+        std::vector<int> premises;
+        for (int i = 0; i < matr.size(); i++)
+            if (matr.alive[i] && matr.origins[i] != ORIGIN_GOAL)
+                premises.push_back(matr.origins[i]);
+        std::sort(premises.begin(), premises.end());
+        premises.erase(std::unique(premises.begin(), premises.end()), premises.end());
+        ClauseSet input = options.minimizeCore ? matr : ClauseSet(0);
 
-        std::cout << "Set of disjuncts:\n"; 
-        PrintfSetDis(matr, k, countVars, vars); 
-        std::cout << "\n";
+        // The time of the search is counted from here
+        SearchGuard guard(options.budget);
+        std::signal(SIGINT, onInterrupt);
+        bool isSolved = false;
+        Reconstruction rec;
+        if (options.preprocess) {
+            PreprocessStats stats;
+            isSolved = Preprocess(matr, proof, rec, stats, guard);
+            std::cout << "Preprocessing removed " << stats.clauses << " disjuncts and "
+                      << stats.variables << " variables (units: " << stats.units << ", pure literals: "
+                      << stats.pure << ", failed literals: " << stats.failed << ")\n";
+        }
+        if (options.eliminate && !isSolved && guard.stopped == STOP_NONE) {
+            int before = matr.count(), eliminated;
+            isSolved = EliminateVariables(matr, proof, rec, eliminated, guard);
+            std::cout << "Variable elimination removed " << eliminated << " variables, disjuncts: "
+                      << before << " -> " << matr.count() << "\n";
+        }
+        if ((options.preprocess || options.eliminate) && !isSolved && options.dimacsFile.empty()) {
+            std::cout << "Simplified set of disjuncts:\n";
+            PrintfSetDis(matr);
+            std::cout << "\n";
+        }
+        if (!options.exportFile.empty()) {
+            std::ofstream out(options.exportFile.c_str());
+            WriteDimacs(matr, out, isSolved);
+            if (!out)
+                throw String("Cannot write the file ") + options.exportFile;
+            if (!options.proofFile.empty()) {
+                // The written disjuncts are the input steps, numbered as in the file
+                proof.steps.clear();
+                proof.empty = -1;
+                for (int i = 0; i < matr.size(); i++)
+                    matr.steps[i] = -1;
+                RecordInputs(matr, proof);
+                if (isSolved)
+                    proof.empty = AddStep(proof, std::vector<int>(), -1, -1);
+                inputs = proof.steps.size();
+                openProof();
+            }
+        }
 
-        bool isSolved = MethodResolution(matr, k, countVars, vars); 
+        const Derivation* derivation = &proof; // the derivation of the verdict
+        std::vector<PortfolioRun> runs;
+        if (isSolved) {
+            PrintfProof(proof, matr);
+        } else if (guard.stopped != STOP_NONE) {
+            // A simplifying pass has been stopped, the search is not started
+        } else if (options.portfolio) {
+            int w = Portfolio(matr, proof, options, runs);
+            for (size_t k = 0; k < runs.size(); k++) {
+                std::cout << "Strategy " << runs[k].name << ": " << runs[k].seconds << " s, ";
+                if (runs[k].verdict >= 0)
+                    std::cout << (runs[k].verdict ? "proven" : "disproven");
+                else if (runs[k].stopped == STOP_CANCELLED && w >= 0)
+                    std::cout << "stopped by the winner";
+                else if (runs[k].stopped != STOP_NONE)
+                    std::cout << StopReason(runs[k].stopped);
+                else
+                    std::cout << "no verdict";
+                std::cout << "\n";
+            }
+            if (w >= 0) {
+                PortfolioRun& win = runs[w];
+                std::cout << "Winner: " << win.name << "\n";
+                isSolved = win.verdict == 1;
+                derivation = win.proof.get();
+                PrintfProof(*win.proof, win.matr);
+                if (!win.values.empty())
+                    PrintfCounterexample(win.matr, rec, win.values, countVars);
+            } else {
+                guard.stopped = runs.empty() ? STOP_CANCELLED : runs[0].stopped;
+            }
+        } else if (options.engine == ENGINE_CDCL) {
+            // The theorem is proven if the disjuncts cannot be satisfied
+            Solver solver(matr);
+            isSolved = !solver.solve(guard) && guard.stopped == STOP_NONE;
+            std::cout << "Conflicts: " << solver.conflicts << ", decisions: " << solver.decisions
+                      << ", propagations: " << solver.propagations << "\n";
+            if (!isSolved && guard.stopped == STOP_NONE) {
+                std::vector<int> values(matr.countVars);
+                for (unsigned j = 0; j < matr.countVars; j++)
+                    values[j] = solver.value(j);
+                PrintfCounterexample(matr, rec, values, countVars);
+            }
+        } else {
+            isSolved = MethodResolution(matr, options, proof, guard); 
+            PrintfProof(proof, matr);
+        }
+        std::signal(SIGINT, SIG_DFL);
         if (isSolved)
             std::cout << "An empty resolvent has been obtained; the theorem is proven\n";
+        else if (guard.stopped != STOP_NONE)
+            std::cout << "The search was stopped after " << guard.seconds() << " s: "
+                      << StopReason(guard.stopped) << "; the theorem is neither proven nor disproven\n";
+        else if (!options.portfolio && options.engine == ENGINE_RESOLUTION
+                 && options.restriction == RESOLVE_LINEAR)
+            std::cout << "Linear resolution has not obtained an empty resolvent; the theorem is not decided\n";
+        else if (!options.portfolio && options.engine == ENGINE_RESOLUTION && options.setOfSupport)
+            // Complete only for consistent premises, which may not be the case
+            std::cout << "The set of support has not obtained an empty resolvent; the theorem is not decided\n";
         else
             std::cout << "It is impossible to obtain an empty resolvent; the theorem is disproven\n";
-        
-        // Delete the matrix
-        for (int i = 0; i < 3 * t; i++) { 
-            delete[] matr[i];
+
+        if (options.core && isSolved) {
+            Core core;
+            if (derivation->empty >= 0) {
+                core = ProofCore(*derivation);
+                PrintfCore(core, inputs, !options.dimacsFile.empty());
+            } else { // no derivation: every premise may be needed
+                core.premises = premises;
+            }
+            if (options.minimizeCore) {
+                SearchGuard minimizing(options.budget);
+                int tries;
+                std::vector<int> minimal = MinimizeCore(input, options, core.premises, minimizing, tries);
+                std::cout << (minimizing.stopped == STOP_NONE ? "Minimal" : "Smaller") << " set of premises:";
+                for (size_t k = 0; k < minimal.size(); k++)
+                    std::cout << (k ? ", " : " ") << minimal[k] + 1;
+                if (minimal.empty())
+                    std::cout << " none";
+                std::cout << " (" << tries << " checks in " << minimizing.seconds() << " s";
+                if (minimizing.stopped != STOP_NONE)
+                    std::cout << ", stopped: " << StopReason(minimizing.stopped);
+                std::cout << ")\n";
+            }
         }
-        delete[] matr;
+        std::cout << "Disjuncts in use: " << matr.count() << ", memory used: "
+                  << (MemoryUsage(matr) + 1023) / 1024 << " KiB\n";
         
     }
     catch (const String& err) {
@@ -449,4 +3430,3 @@ int main() {
     
     return 0;
 }
-
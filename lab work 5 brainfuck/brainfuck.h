@@ -1,21 +1,75 @@
-#include <deque>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
 #include <string>
+#include <vector>
+
+// Operations of the compiled program
+enum OpCode {
+    ADD,  // add arg to the current cell
+    MOVE, // move the pointer by arg cells
+    JZ,   // jump to arg if the current cell is zero
+    JNZ,  // jump to arg if the current cell is not zero
+    OUT,  // output the current cell
+    IN,   // read the current cell
+    CLEAR,  // set the current cell to zero
+    MULADD, // add the current cell times arg to the cell at offset
+    SCAN    // move the pointer by arg cells until a zero cell
+};
+
+struct Instruction {
+    OpCode op;
+    int arg;
+    int offset = 0;
+};
+
+// How the program is run
+enum Engine {
+    INTERPRETER, // dispatch over the instructions
+    NATIVE       // compile to x86-64 code, the interpreter on other hosts
+};
+
+class Brainfuck;
+
+// State shared with the native code, which reads the bounds of the tape
+struct JitContext {
+    Brainfuck* bf;
+    std::uint8_t* begin;
+    std::uint8_t* end;
+    std::string* output;
+};
 
 class Brainfuck {
 
     public:
         Brainfuck(const std::string& input);
-        void execute(std::string& output, bool ascii);
+        void execute(std::string& output, bool ascii, Engine engine = NATIVE);
+        static bool native_supported();
+        void transpile(std::ostream& out, bool ascii) const;
 
     private:
-        std::deque<std::uint8_t> cells;
+        // Contiguous tape, the origin moves when it grows to the left
+        std::vector<std::uint8_t> cells;
+        // The current cell
+        std::uint8_t* cell;
         std::string input;
         bool ascii;
-        int current_index;
-        int current_char;
+        int current_instruction;
+        // The program compiled from the characters of the input
+        std::vector<Instruction> program;
         void remove_spaces();
         void remove_new_lines();
-        void find_matching_end_bracket();
-        void find_matching_start_bracket();
-    void op_codes(const char& cur, std::string& output);
+        void compile();
+        bool fold_loop(int start);
+        void reach(int offset);
+        void grow(std::ptrdiff_t index);
+        void move(int shift);
+        void read_cell();
+        void interpret(std::string& output);
+        bool execute_native(std::string& output);
+        void emit_reach(std::vector<std::uint8_t>& code, int offset);
+        // Called from the native code
+        static std::uint8_t* jit_reach(JitContext* context, std::uint8_t* cell, int offset);
+        static void jit_output(JitContext* context, int value);
+        static void jit_input(JitContext* context, std::uint8_t* cell);
 };
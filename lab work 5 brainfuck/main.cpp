@@ -2,16 +2,28 @@
 
 #include <iostream>
 #include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
 #include <string>
 #include <windows.h>
 #include "brainfuck.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define BRAINFUCK_JIT
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+#endif
+
 Brainfuck::Brainfuck(const std::string& input) : input(input) {
     remove_spaces();
     remove_new_lines();
+    compile();
     cells.assign(30'000, 0);
-    current_index = 0;
-    current_char = 0;
+    cell = cells.data();
+    current_instruction = 0;
 }
 // Remove spaces
 void Brainfuck::remove_spaces() {
@@ -21,110 +33,669 @@ void Brainfuck::remove_spaces() {
 void Brainfuck::remove_new_lines() {
     input.erase(std::remove(input.begin(), input.end(), '\n'), input.end());
 }
-// Find the matching closing bracket
-void Brainfuck::find_matching_end_bracket() {
-    int expected = 0;
-    int found = 0;
-    while (current_char < input.length()) {
-        if (input[current_char] == '[') expected++;
-        if (input[current_char] == ']') {
-            found++;
-            if (expected == found) break;
-        }
-        current_char++;
-    }
-}
-// Find the matching opening bracket
-void Brainfuck::find_matching_start_bracket() {
-    int expected = 0;
-    int found = 0;
-    while (current_char >= 0) {
-        if (input[current_char] == ']') expected++;
-        if (input[current_char] == '[') {
-            found++;
-            if (expected == found) break;
-        }
-        current_char--;
-    }
-}
-// Pointer movement depends on the character
-void Brainfuck::op_codes(const char& cur, std::string& output) {
-    switch (cur) {
-        case '>':
-            if (current_index == cells.size() - 1) {
-                cells.emplace_back(0);
-            } else {
-                current_index++;
-            }
-            break;
-        case '<':
-            if (current_index == 0) {
-                cells.emplace_front(0);
-            } else {
-                current_index--;
-            }
-            break;
-        case '+':
-            cells[current_index]++;
-            break;
-        case '-':
-            cells[current_index]--;
-            break;
-        case '.':
-            if (!ascii) {
-                output += std::to_string(cells[current_index]);
-            } else {
-                output += cells[current_index];
+// Compile the characters into instructions: a run of '+' and '-' becomes
+// one ADD and a run of '>' and '<' one MOVE; a bracket jumps straight to
+// the instruction after its pair and a common loop is folded into a
+// closed form. An unbalanced bracket is reported with its position
+void Brainfuck::compile() {
+    std::vector<int> open; // instructions of the unmatched '['
+    std::vector<int> open_at; // and their positions in the input
+    for (int i = 0; i < (int) input.length(); i++) {
+        char cur = input[i];
+        switch (cur) {
+            case '+':
+            case '-':
+            case '>':
+            case '<': {
+                bool is_add = cur == '+' || cur == '-';
+                int arg = 0;
+                for (; i < (int) input.length(); i++) {
+                    if ((input[i] == '+' && is_add) || (input[i] == '>' && !is_add)) {
+                        arg++;
+                    } else if ((input[i] == '-' && is_add) || (input[i] == '<' && !is_add)) {
+                        arg--;
+                    } else {
+                        break;
+                    }
+                }
+                i--;
+                if (is_add) {
+                    arg &= 0xFF;
+                }
+                if (arg != 0) {
+                    program.push_back({is_add ? ADD : MOVE, arg});
+                }
+                break;
             }
-            break;
-        case ',': {
-            std::string in;
-            std::cout << "Enter a number from 0 to 255:\n ";
-            std::cin >> in;
-            if (!in.empty() && std::all_of(in.begin(), in.end(), ::isdigit)) {
-                auto c_in = stoi(in);
-                if (c_in >= 0 && c_in <= 255) {
-                    cells[current_index] = c_in;
-                } else {
-                    std::cout << "Invalid input! Enter a number from 0 to 255! :\n" << std::endl;
+            case '.':
+                program.push_back({OUT, 0});
+                break;
+            case ',':
+                program.push_back({IN, 0});
+                break;
+            case '[':
+                open.push_back((int) program.size());
+                open_at.push_back(i);
+                program.push_back({JZ, 0});
+                break;
+            case ']':
+                if (open.empty()) {
+                    throw std::string("Unbalanced brackets! No opening bracket for ']' at " + std::to_string(i));
                 }
+                if (!fold_loop(open.back())) {
+                    program[open.back()].arg = (int) program.size();
+                    program.push_back({JNZ, open.back()});
+                }
+                open.pop_back();
+                open_at.pop_back();
+                break;
+            default:
+                std::cerr << "Invalid Brainfuck program! Unknown character at " << i << std::endl;
+                break;
+        }
+    }
+    if (!open.empty()) {
+        throw std::string("Unbalanced brackets! No closing bracket for '[' at " + std::to_string(open_at.back()));
+    }
+}
+// Replace the loop whose JZ is at start by a closed form: [>] and [<]
+// become SCAN, a loop of ADD and MOVE that returns to its cell and
+// steps it by one becomes MULADD for each other cell and CLEAR
+bool Brainfuck::fold_loop(int start) {
+    int end = (int) program.size();
+    if (end == start + 2 && program[start + 1].op == MOVE) {
+        int stride = program[start + 1].arg;
+        program.resize(start);
+        program.push_back({SCAN, stride});
+        return true;
+    }
+    std::vector<std::pair<int, int>> deltas; // offset and change of a cell
+    int offset = 0;
+    for (int i = start + 1; i < end; i++) {
+        if (program[i].op == MOVE) {
+            offset += program[i].arg;
+        } else if (program[i].op == ADD) {
+            auto it = std::find_if(deltas.begin(), deltas.end(),
+                                   [offset](const std::pair<int, int>& d) { return d.first == offset; });
+            if (it == deltas.end()) {
+                deltas.push_back({offset, program[i].arg});
             } else {
-                std::cout << "Invalid input!" << std::endl;
+                it->second += program[i].arg;
             }
-            break;
+        } else {
+            return false;
         }
-        case '[':
-            if (cells[current_index] == 0) {
-                find_matching_end_bracket();
-            }
-            break;
-        case ']':
-            if (cells[current_index] != 0) {
-                find_matching_start_bracket();
-            }
-            break;
-        default:
-            std::cerr << "Invalid Brainfuck program! Unknown character at " << current_index << std::endl;
-            break;
+    }
+    if (offset != 0) {
+        return false;
+    }
+    int step = 0;
+    for (const auto& d : deltas) {
+        if (d.first == 0) {
+            step = d.second & 0xFF;
+        }
+    }
+    if (step != 1 && step != 0xFF) {
+        return false;
+    }
+    // The loop runs cell times when it counts down, 256 - cell when it counts up
+    int sign = step == 1 ? -1 : 1;
+    program.resize(start);
+    for (const auto& d : deltas) {
+        if (d.first != 0 && (d.second & 0xFF) != 0) {
+            program.push_back({MULADD, (sign * d.second) & 0xFF, d.first});
+        }
+    }
+    program.push_back({CLEAR, 0});
+    return true;
+}
+// Make sure the cell at offset from the pointer exists. Only moves
+// check the bounds, every other instruction uses the cell directly
+void Brainfuck::reach(int offset) {
+    std::ptrdiff_t index = cell - cells.data() + offset;
+    if (index < 0 || index >= (std::ptrdiff_t) cells.size()) {
+        grow(index);
+    }
+}
+// Double the tape towards index until it fits, growing to the left
+// moves the old cells and the origin to the right
+void Brainfuck::grow(std::ptrdiff_t index) {
+    std::ptrdiff_t position = cell - cells.data();
+    std::ptrdiff_t size = (std::ptrdiff_t) cells.size();
+    std::ptrdiff_t extra = size;
+    if (index < 0) {
+        while (extra < -index) {
+            extra *= 2;
+        }
+        cells.insert(cells.begin(), extra, 0);
+        position += extra;
+    } else {
+        while (size + extra <= index) {
+            extra *= 2;
+        }
+        cells.resize(size + extra, 0);
+    }
+    cell = cells.data() + position;
+}
+// Move the pointer, the tape grows at both ends
+void Brainfuck::move(int shift) {
+    reach(shift);
+    cell += shift;
+}
+// Read a number into the current cell
+void Brainfuck::read_cell() {
+    std::string in;
+    std::cout << "Enter a number from 0 to 255:\n ";
+    std::cin >> in;
+    if (!in.empty() && std::all_of(in.begin(), in.end(), ::isdigit)) {
+        auto c_in = stoi(in);
+        if (c_in >= 0 && c_in <= 255) {
+            *cell = c_in;
+        } else {
+            std::cout << "Invalid input! Enter a number from 0 to 255! :\n" << std::endl;
+        }
+    } else {
+        std::cout << "Invalid input!" << std::endl;
     }
 }
 // Execute and output
-void Brainfuck::execute(std::string& output, bool ascii) {
+void Brainfuck::execute(std::string& output, bool ascii, Engine engine) {
     this->ascii = ascii;
-    while (current_char < input.length()) {
-        op_codes(input[current_char], output);
-        current_char++;
+    if (engine == NATIVE && current_instruction == 0 && execute_native(output)) {
+        return;
+    }
+    interpret(output);
+}
+// Run the instructions one by one
+void Brainfuck::interpret(std::string& output) {
+    for (; current_instruction < (int) program.size(); current_instruction++) {
+        const Instruction& ins = program[current_instruction];
+        switch (ins.op) {
+            case ADD:
+                *cell += ins.arg;
+                break;
+            case MOVE:
+                move(ins.arg);
+                break;
+            case JZ:
+                if (*cell == 0) {
+                    current_instruction = ins.arg;
+                }
+                break;
+            case JNZ:
+                if (*cell != 0) {
+                    current_instruction = ins.arg;
+                }
+                break;
+            case OUT:
+                if (!ascii) {
+                    output += std::to_string(*cell);
+                } else {
+                    output += *cell;
+                }
+                break;
+            case IN:
+                read_cell();
+                break;
+            case CLEAR:
+                *cell = 0;
+                break;
+            case MULADD:
+                if (*cell != 0) {
+                    reach(ins.offset);
+                    cell[ins.offset] += *cell * ins.arg;
+                }
+                break;
+            case SCAN:
+                while (*cell != 0) {
+                    move(ins.arg);
+                }
+                break;
+        }
+    }
+}
+
+// Whether the native code can run on this host
+bool Brainfuck::native_supported() {
+#ifdef BRAINFUCK_JIT
+    return true;
+#else
+    return false;
+#endif
+}
+// Grow the tape for the native code and give it the new bounds
+std::uint8_t* Brainfuck::jit_reach(JitContext* context, std::uint8_t* cell, int offset) {
+    Brainfuck* bf = context->bf;
+    bf->cell = cell;
+    bf->reach(offset);
+    context->begin = bf->cells.data();
+    context->end = bf->cells.data() + bf->cells.size();
+    return bf->cell;
+}
+// Output a cell for the native code
+void Brainfuck::jit_output(JitContext* context, int value) {
+    if (!context->bf->ascii) {
+        *context->output += std::to_string(value);
+    } else {
+        *context->output += (char) value;
+    }
+}
+// Read a cell for the native code
+void Brainfuck::jit_input(JitContext* context, std::uint8_t* cell) {
+    context->bf->cell = cell;
+    context->bf->read_cell();
+}
+
+#ifdef BRAINFUCK_JIT
+static_assert(offsetof(JitContext, begin) == 8 && offsetof(JitContext, end) == 16,
+              "The native code reads the bounds of the tape at these offsets");
+
+// Registers of the first three arguments differ between the calling conventions
+#ifdef _WIN32
+static const std::vector<std::uint8_t> ENTER = {0x49, 0x89, 0xCC, 0x48, 0x89, 0xD3}; // mov r12, rcx; mov rbx, rdx
+static const std::vector<std::uint8_t> ARG_CONTEXT = {0x4C, 0x89, 0xE1};             // mov rcx, r12
+static const std::vector<std::uint8_t> ARG_CELL = {0x48, 0x89, 0xDA};                // mov rdx, rbx
+static const std::vector<std::uint8_t> ARG_VALUE = {0x0F, 0xB6, 0x13};               // movzx edx, byte [rbx]
+static const std::vector<std::uint8_t> ARG_OFFSET = {0x41, 0xB8};                    // mov r8d, imm32
+static const std::vector<std::uint8_t> SHADOW = {0x48, 0x83, 0xEC, 0x20};            // sub rsp, 32
+static const std::vector<std::uint8_t> UNSHADOW = {0x48, 0x83, 0xC4, 0x20};          // add rsp, 32
+#else
+static const std::vector<std::uint8_t> ENTER = {0x49, 0x89, 0xFC, 0x48, 0x89, 0xF3}; // mov r12, rdi; mov rbx, rsi
+static const std::vector<std::uint8_t> ARG_CONTEXT = {0x4C, 0x89, 0xE7};             // mov rdi, r12
+static const std::vector<std::uint8_t> ARG_CELL = {0x48, 0x89, 0xDE};                // mov rsi, rbx
+static const std::vector<std::uint8_t> ARG_VALUE = {0x0F, 0xB6, 0x33};               // movzx esi, byte [rbx]
+static const std::vector<std::uint8_t> ARG_OFFSET = {0xBA};                          // mov edx, imm32
+static const std::vector<std::uint8_t> SHADOW = {};
+static const std::vector<std::uint8_t> UNSHADOW = {};
+#endif
+
+static void emit(std::vector<std::uint8_t>& code, const std::vector<std::uint8_t>& bytes) {
+    code.insert(code.end(), bytes.begin(), bytes.end());
+}
+static void emit32(std::vector<std::uint8_t>& code, std::int32_t value) {
+    for (int i = 0; i < 4; i++) {
+        code.push_back((std::uint8_t) ((std::uint32_t) value >> (8 * i)));
+    }
+}
+// movabs r11, function; call r11
+static void emit_call(std::vector<std::uint8_t>& code, const void* function) {
+    emit(code, {0x49, 0xBB});
+    std::uint64_t address = (std::uint64_t) (std::uintptr_t) function;
+    for (int i = 0; i < 8; i++) {
+        code.push_back((std::uint8_t) (address >> (8 * i)));
+    }
+    emit(code, {0x41, 0xFF, 0xD3});
+}
+static void patch32(std::vector<std::uint8_t>& code, std::size_t at, std::int32_t value) {
+    for (int i = 0; i < 4; i++) {
+        code[at + i] = (std::uint8_t) ((std::uint32_t) value >> (8 * i));
+    }
+}
+#endif
+
+// Make sure the cell at offset from the pointer in rbx exists, the tape
+// only grows through a call to jit_reach when the bounds are crossed
+void Brainfuck::emit_reach(std::vector<std::uint8_t>& code, int offset) {
+#ifdef BRAINFUCK_JIT
+    emit(code, {0x48, 0x8D, 0x83}); // lea rax, [rbx + offset]
+    emit32(code, offset);
+    if (offset > 0) {
+        emit(code, {0x49, 0x3B, 0x44, 0x24, 0x10, 0x72, 0x00}); // cmp rax, [r12 + 16]; jb done
+    } else {
+        emit(code, {0x49, 0x3B, 0x44, 0x24, 0x08, 0x73, 0x00}); // cmp rax, [r12 + 8]; jae done
+    }
+    std::size_t skip = code.size();
+    emit(code, ARG_CONTEXT);
+    emit(code, ARG_CELL);
+    emit(code, ARG_OFFSET);
+    emit32(code, offset);
+    emit_call(code, (const void*) &Brainfuck::jit_reach);
+    emit(code, {0x48, 0x89, 0xC3}); // mov rbx, rax
+    code[skip - 1] = (std::uint8_t) (code.size() - skip);
+#endif
+}
+// Compile the instructions to x86-64 code and run it. The pointer to the
+// current cell lives in rbx and the context in r12. Returns false when
+// the host can not run it
+bool Brainfuck::execute_native(std::string& output) {
+#ifdef BRAINFUCK_JIT
+    std::vector<std::uint8_t> code;
+    emit(code, {0x53, 0x55, 0x41, 0x54}); // push rbx; push rbp; push r12
+    emit(code, SHADOW);
+    emit(code, ENTER);
+    std::vector<std::size_t> address(program.size() + 1); // start of each instruction
+    std::vector<std::pair<std::size_t, int>> jumps;         // rel32 to patch and its instruction
+    for (int i = 0; i < (int) program.size(); i++) {
+        const Instruction& ins = program[i];
+        address[i] = code.size();
+        switch (ins.op) {
+            case ADD:
+                emit(code, {0x80, 0x03, (std::uint8_t) ins.arg}); // add byte [rbx], arg
+                break;
+            case MOVE:
+                emit_reach(code, ins.arg);
+                emit(code, {0x48, 0x81, 0xC3}); // add rbx, arg
+                emit32(code, ins.arg);
+                break;
+            case JZ:
+            case JNZ:
+                emit(code, {0x80, 0x3B, 0x00}); // cmp byte [rbx], 0
+                emit(code, {0x0F, (std::uint8_t) (ins.op == JZ ? 0x84 : 0x85)}); // je or jne
+                jumps.push_back({code.size(), ins.arg + 1});
+                emit32(code, 0);
+                break;
+            case OUT:
+                emit(code, ARG_CONTEXT);
+                emit(code, ARG_VALUE);
+                emit_call(code, (const void*) &Brainfuck::jit_output);
+                break;
+            case IN:
+                emit(code, ARG_CONTEXT);
+                emit(code, ARG_CELL);
+                emit_call(code, (const void*) &Brainfuck::jit_input);
+                break;
+            case CLEAR:
+                emit(code, {0xC6, 0x03, 0x00}); // mov byte [rbx], 0
+                break;
+            case MULADD:
+                emit_reach(code, ins.offset);
+                emit(code, {0x0F, 0xB6, 0x03, 0x69, 0xC0}); // movzx eax, byte [rbx]; imul eax, eax, arg
+                emit32(code, ins.arg);
+                emit(code, {0x00, 0x83}); // add byte [rbx + offset], al
+                emit32(code, ins.offset);
+                break;
+            case SCAN: {
+                std::size_t loop = code.size();
+                emit(code, {0x80, 0x3B, 0x00, 0x0F, 0x84}); // cmp byte [rbx], 0; je done
+                std::size_t done = code.size();
+                emit32(code, 0);
+                emit_reach(code, ins.arg);
+                emit(code, {0x48, 0x81, 0xC3}); // add rbx, arg
+                emit32(code, ins.arg);
+                emit(code, {0xE9}); // jmp loop
+                emit32(code, (std::int32_t) (loop - (code.size() + 4)));
+                patch32(code, done, (std::int32_t) (code.size() - (done + 4)));
+                break;
+            }
+        }
+    }
+    address[program.size()] = code.size();
+    for (const auto& jump : jumps) {
+        patch32(code, jump.first, (std::int32_t) (address[jump.second] - (jump.first + 4)));
+    }
+    emit(code, {0x48, 0x89, 0xD8}); // mov rax, rbx
+    emit(code, UNSHADOW);
+    emit(code, {0x41, 0x5C, 0x5D, 0x5B, 0xC3}); // pop r12; pop rbp; pop rbx; ret
+
+#ifdef _WIN32
+    void* memory = VirtualAlloc(nullptr, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    if (memory == nullptr) {
+        return false;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    DWORD protection;
+    if (!VirtualProtect(memory, code.size(), PAGE_EXECUTE_READ, &protection)) {
+        VirtualFree(memory, 0, MEM_RELEASE);
+        return false;
+    }
+    FlushInstructionCache(GetCurrentProcess(), memory, code.size());
+#else
+    void* memory = mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return false;
+    }
+    std::memcpy(memory, code.data(), code.size());
+    if (mprotect(memory, code.size(), PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, code.size());
+        return false;
+    }
+#endif
+
+    JitContext context = {this, cells.data(), cells.data() + cells.size(), &output};
+    auto run = (std::uint8_t* (*)(JitContext*, std::uint8_t*)) memory;
+    cell = run(&context, cell);
+    current_instruction = (int) program.size();
+
+#ifdef _WIN32
+    VirtualFree(memory, 0, MEM_RELEASE);
+#else
+    munmap(memory, code.size());
+#endif
+    return true;
+#else
+    (void) output;
+    return false;
+#endif
+}
+
+// Runtime of the C program: the same growing tape, input and output
+// as the interpreter. The output and input parts are written only for
+// the programs that use them
+static const char* C_RUNTIME = R"(#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static unsigned char* tape;
+static size_t size = 30000;
+static unsigned char* p;
+
+static void fail(void) {
+    fputs("Out of memory!\n", stderr);
+    exit(EXIT_FAILURE);
+}
+static void grow(long index) {
+    long position = (long) (p - tape);
+    size_t extra = size;
+    if (index < 0) {
+        while ((long) extra < -index) {
+            extra *= 2;
+        }
+        unsigned char* bigger = calloc(size + extra, 1);
+        if (bigger == NULL) {
+            fail();
+        }
+        memcpy(bigger + extra, tape, size);
+        free(tape);
+        tape = bigger;
+        position += (long) extra;
+    } else {
+        while ((long) (size + extra) <= index) {
+            extra *= 2;
+        }
+        unsigned char* bigger = realloc(tape, size + extra);
+        if (bigger == NULL) {
+            fail();
+        }
+        memset(bigger + size, 0, extra);
+        tape = bigger;
+    }
+    size += extra;
+    p = tape + position;
+}
+static inline void reach(long offset) {
+    long index = (long) (p - tape) + offset;
+    if (index < 0 || index >= (long) size) {
+        grow(index);
+    }
+}
+)";
+static const char* C_OUTPUT = R"(static char* out;
+static size_t out_length, out_capacity;
+
+static void put(const char* text, size_t length) {
+    if (out_length + length > out_capacity) {
+        out_capacity = out_capacity * 2 + length;
+        out = realloc(out, out_capacity);
+        if (out == NULL) {
+            fail();
+        }
+    }
+    memcpy(out + out_length, text, length);
+    out_length += length;
+}
+static void output(int ascii) {
+    if (ascii) {
+        char c = (char) *p;
+        put(&c, 1);
+    } else {
+        char number[4];
+        put(number, (size_t) sprintf(number, "%d", *p));
     }
 }
+)";
+static const char* C_INPUT = R"(static void input(void) {
+    char in[1024] = "";
+    size_t i;
+    printf("Enter a number from 0 to 255:\n ");
+    if (scanf("%1023s", in) != 1) {
+        in[0] = '\0';
+    }
+    for (i = 0; in[i] != '\0' && isdigit((unsigned char) in[i]); i++) {
+    }
+    if (in[0] != '\0' && in[i] == '\0') {
+        long c_in = i > 3 ? 256 : strtol(in, NULL, 10);
+        if (c_in >= 0 && c_in <= 255) {
+            *p = (unsigned char) c_in;
+        } else {
+            printf("Invalid input! Enter a number from 0 to 255! :\n\n");
+            fflush(stdout);
+        }
+    } else {
+        printf("Invalid input!\n");
+        fflush(stdout);
+    }
+}
+)";
+static const char* C_MAIN = R"(
+int main(void) {
+    tape = calloc(size, 1);
+    if (tape == NULL) {
+        fail();
+    }
+    p = tape;
+)";
 
-int main(){
+// Write the compiled program as a standalone C program, loops and the
+// folded idioms keep their shape so a C compiler can optimize them
+void Brainfuck::transpile(std::ostream& out, bool ascii) const {
+    auto uses = [this](OpCode op) {
+        return std::any_of(program.begin(), program.end(), [op](const Instruction& ins) { return ins.op == op; });
+    };
+    out << C_RUNTIME;
+    if (uses(OUT)) {
+        out << C_OUTPUT;
+    }
+    if (uses(IN)) {
+        out << C_INPUT;
+    }
+    out << C_MAIN;
+    std::string indent = "    ";
+    for (const Instruction& ins : program) {
+        switch (ins.op) {
+            case ADD:
+                out << indent << "*p += " << ins.arg << ";\n";
+                break;
+            case MOVE:
+                out << indent << "reach(" << ins.arg << "); p += " << ins.arg << ";\n";
+                break;
+            case JZ:
+                out << indent << "while (*p) {\n";
+                indent += "    ";
+                break;
+            case JNZ:
+                indent.resize(indent.size() - 4);
+                out << indent << "}\n";
+                break;
+            case OUT:
+                out << indent << "output(" << ascii << ");\n";
+                break;
+            case IN:
+                out << indent << "input();\n";
+                break;
+            case CLEAR:
+                out << indent << "*p = 0;\n";
+                break;
+            case MULADD:
+                out << indent << "if (*p) { reach(" << ins.offset << "); p[" << ins.offset << "] += *p * "
+                    << ins.arg << "; }\n";
+                break;
+            case SCAN:
+                out << indent << "while (*p) { reach(" << ins.arg << "); p += " << ins.arg << "; }\n";
+                break;
+        }
+    }
+    if (uses(OUT)) {
+        out << "    fwrite(out, 1, out_length, stdout);\n";
+    }
+    out << "    putchar('\\n');\n";
+    out << "    return EXIT_SUCCESS;\n";
+    out << "}\n";
+}
+// Write the C program and compile it with the local C compiler
+static bool compile_native(const Brainfuck& bf, const std::string& executable) {
+    std::string source = executable + ".c";
+    std::ofstream file(source);
+    if (!file) {
+        throw std::string("Can not write " + source);
+    }
+    bf.transpile(file, true);
+    file.close();
+    if (std::system(nullptr) == 0) {
+        return false;
+    }
+    std::string command = "cc -O3 -o \"" + executable + "\" \"" + source + "\"";
+    return std::system(command.c_str()) == 0;
+}
+
+int main(int argc, char* argv[]){
     SetConsoleOutputCP(CP_UTF8); // Enable Russian language
+    Engine engine = NATIVE;
+    std::string c_file;     // write the program as C
+    std::string executable; // and compile it ahead of time
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--engine=interpreter") {
+            engine = INTERPRETER;
+        } else if (option == "--engine=jit") {
+            engine = NATIVE;
+        } else if (option.rfind("--emit-c=", 0) == 0) {
+            c_file = option.substr(9);
+        } else if (option.rfind("--compile=", 0) == 0) {
+            executable = option.substr(10);
+        } else {
+            std::cerr << "Unknown option: " << option << std::endl;
+            std::cerr << "Usage: " << argv[0] << " [--engine=jit|--engine=interpreter] [--emit-c=FILE] [--compile=EXECUTABLE]" << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
     std::string brainfuck_code;
     std::string output_w_ascii;
     std::cout << "Enter your Brainfuck code: " << std::endl;
     std::cin >> brainfuck_code;
-    Brainfuck bf1(brainfuck_code);
-    bf1.execute(output_w_ascii, true);
+    try {
+        Brainfuck bf1(brainfuck_code);
+        if (!c_file.empty() || !executable.empty()) {
+            if (!c_file.empty()) {
+                std::ofstream file(c_file);
+                if (!file) {
+                    throw std::string("Can not write " + c_file);
+                }
+                bf1.transpile(file, true);
+            }
+            if (!executable.empty()) {
+                if (!compile_native(bf1, executable)) {
+                    throw std::string("No C compiler, the program is left in " + executable + ".c");
+                }
+                std::cout << "Compiled to " << executable << std::endl;
+            }
+            return EXIT_SUCCESS;
+        }
+        bf1.execute(output_w_ascii, true, engine);
+    } catch (const std::string& err) {
+        std::cerr << err << std::endl;
+        return EXIT_FAILURE;
+    }
     std::cout << output_w_ascii << std::endl;
     return EXIT_SUCCESS;
 }